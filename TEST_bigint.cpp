@@ -8,10 +8,35 @@
 #include <algorithm>  //for std::generate_n
 #include <ctime>
 #include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <new>
+#include <thread>
+#include <vector>
+#include <stdexcept>
 
 using namespace std;
 using namespace bigint;
 
+//count every heap allocation so benchmarks can report allocator traffic
+static size_t allocations = 0;
+
+void *operator new(std::size_t size)
+{
+    allocations++;
+    void *p = std::malloc(size ? size : 1);
+    if (p == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
 static std::random_device rd;
 static std::mt19937 gen(rd());
 
@@ -31,22 +56,979 @@ std::string random_hex(size_t length)
     return ret;
 }
 
+std::string random_digits(size_t length, int base)
+{
+    static std::string const default_chars = "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+    std::uniform_int_distribution<int> dist{0, base - 1};
+
+    std::string ret;
+    std::generate_n(std::back_inserter(ret), length, [&] {
+        int d = dist(gen);
+        return default_chars[d < 10 || random_int64() > 0 ? d : d + 26];
+    });
+    return ret;
+}
+
+BigInt random_bigint(size_t digits)
+{
+    BigInt a(random_hex(digits * sizeof(digit_t) * 2), 16);
+    return random_int64() < 0 ? -std::move(a) : a;
+}
+
+void test_arith()
+{
+    BigInt a = random_bigint(3);
+    BigInt b = random_bigint(5);
+    BigInt c = random_bigint(2);
+    ddigit_t d = random_int64();
+
+    cout << "assert(" << a << " + " << b << " - (" << c << " - " << a << ") == " << (a + b - (c - a)) << ")" << endl;
+    cout << "assert(" << a << " - (" << b << " + " << c << ") == " << (a - (b + c)) << ")" << endl;
+    cout << "assert((" << a << " + " << b << ") * (" << c << " - " << b << ") == " << ((a + b) * (c - b)) << ")" << endl;
+    cout << "assert(-(" << a << " - " << BigInt(d) << ") + " << c << " == " << (-(a - d) + c) << ")" << endl;
+    cout << "assert(" << BigInt(d) << " - (" << a << " * " << b << ") == " << (d - a * b) << ")" << endl;
+    cout << "assert(" << a << " - " << a << " + " << c << " == " << (a - a + c) << ")" << endl;
+}
+
+void test_shift()
+{
+    //bit and whole digit counts on short, inline sized and long values, in place and out of place
+    const size_t sizes[] = {1, 3, 4, 40, 300};
+    const size_t w = sizeof(digit_t) * 8;
+    for (size_t size : sizes)
+    {
+        BigInt a = random_bigint(size);
+        BigInt m = abs(a);
+        const size_t counts[] = {0, 1, w - 1, w, 3 * w + 5, size * w - 1, (size_t)(random_int64() & 0xfff)};
+        for (size_t n : counts)
+        {
+            BigInt l(a);
+            l <<= n;
+            BigInt r(m);
+            r >>= n;
+            cout << "assert((" << a << " << " << BigInt((ddigit_t)n) << ") == " << (a << n) << " && " << l << " == " << (a << n) << ")" << endl;
+            cout << "assert((" << m << " >> " << BigInt((ddigit_t)n) << ") == " << (m >> n) << " && " << r << " == " << (m >> n) << ")" << endl;
+        }
+        cout << "assert((" << m << " >> " << BigInt((ddigit_t)(size * w)) << ") == " << (m >> size * w) << ")" << endl;
+
+        //signed counts shift by their magnitude
+        BigInt l(a), r(m);
+        l <<= -5;
+        r >>= (ddigit_t)-5;
+        cout << "assert((" << a << " << 5n) == " << (a << (ddigit_t)-5) << " && " << l << " == " << (BigInt(a) << -5) << ")" << endl;
+        cout << "assert((" << m << " >> 5n) == " << (m >> -5) << " && " << r << " == " << (BigInt(m) >> (ddigit_t)-5) << ")" << endl;
+    }
+}
+
+void test_bitwise()
+{
+    cout << "function bits(x) { x = x < 0n ? -x : x; return x == 0n ? 0 : x.toString(2).length; }" << endl;
+    cout << "function ones(x) { x = x < 0n ? -x : x; return x.toString(2).split('1').length - 1; }" << endl;
+
+    //every sign combination, with powers of two and -1 for the longest carry chains
+    const size_t sizes[][2] = {{1, 1}, {2, 5}, {4, 4}, {40, 3}, {300, 301}};
+    for (auto &size : sizes)
+    {
+        BigInt x = abs(random_bigint(size[0]));
+        BigInt y = abs(random_bigint(size[1]));
+        BigInt values[] = {x, -x, y, -y, BigInt(1) << (size[1] * sizeof(digit_t) * 8), -(BigInt(1) << (size[0] * sizeof(digit_t) * 8 - 1)), BigInt(-1), BigInt()};
+        for (auto &a : values)
+        {
+            for (auto &b : values)
+            {
+                cout << "assert((" << a << " & " << b << ") == " << (a & b) << ")" << endl;
+                cout << "assert((" << a << " | " << b << ") == " << (a | b) << ")" << endl;
+                cout << "assert((" << a << " ^ " << b << ") == " << (a ^ b) << ")" << endl;
+            }
+
+            size_t n = (size_t)(random_int64() & 0xffff) % (a.bit_length() + 70);
+            BigInt c(a);
+            BigInt d(a);
+            c.set_bit(n);
+            d.set_bit(n, false);
+            cout << "assert(bits(" << a << ") == 0x" << a.bit_length() << " && ones(" << a << ") == 0x" << a.popcount() << ")" << endl;
+            cout << "assert(((" << a << " >> 0x" << n << "n) & 1n) == " << (a.test_bit(n) ? "1n" : "0n") << ")" << endl;
+            cout << "assert((" << a << " | (1n << 0x" << n << "n)) == " << c << " && (" << a << " & ~(1n << 0x" << n << "n)) == " << d << ")" << endl;
+        }
+        BigInt z(x);
+        z &= z;
+        z ^= z;
+        cout << "assert(" << z << " == 0n)" << endl;
+    }
+}
+
+void test_mul()
+{
+    //operand sizes straddling the Karatsuba, Toom-3, Toom-4 and NTT thresholds, balanced and unbalanced
+    size_t sizes[][2] = {{100, 140}, {400, 400}, {390, 1200}, {1600, 1700}, {1600, 5000}, {25000, 26000}};
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        BigInt a = random_bigint(sizes[i][0]);
+        BigInt b = random_bigint(sizes[i][1]);
+        cout << "assert(" << a << " * " << b << " == " << (a * b) << ")" << endl;
+    }
+
+    //squaring takes its own path when both operands are the same object
+    size_t squares[] = {3, 200, 600, 2500, 5000};
+    for (size_t i = 0; i < sizeof(squares) / sizeof(squares[0]); i++)
+    {
+        BigInt a = random_bigint(squares[i]);
+        BigInt b = a;
+        b *= b;
+        cout << "assert(" << a << " * " << a << " == " << (a * a) << ")" << endl;
+        cout << "assert((" << a << ") ** 2n == " << b << ")" << endl;
+    }
+
+    //the pool resized while another thread multiplies on it
+    BigInt a = random_bigint(3000);
+    BigInt b = random_bigint(2900);
+    BigInt p[4];
+    std::thread t([&] {
+        for (auto &r : p)
+        {
+            r = a * b;
+        }
+    });
+    for (size_t threads = 1; threads < 9; threads++)
+    {
+        BigInt::setThreads(threads % 4 + 1);
+    }
+    t.join();
+    BigInt::setThreads(1);
+    for (auto &r : p)
+    {
+        cout << "assert(" << a << " * " << b << " == " << r << ")" << endl;
+    }
+}
+
+void test_addmul()
+{
+    //basecase, Karatsuba and Toom sized products into accumulators that are shorter, longer and of either sign
+    const size_t sizes[][3] = {{1, 1, 1}, {3, 2, 9}, {4, 4, 8}, {40, 30, 2}, {300, 200, 700}, {700, 100, 500}, {2500, 2100, 10}};
+    for (auto &size : sizes)
+    {
+        BigInt a = random_bigint(size[0]);
+        BigInt b = random_bigint(size[1]);
+        BigInt c = random_bigint(size[2]);
+        ddigit_t d = random_int64();
+        BigInt e(d);
+
+        BigInt x(c);
+        BigInt y(c);
+        x.addmul(a, b);
+        y.submul(a, b);
+        cout << "assert(" << c << " + " << a << " * " << b << " == " << x << " && " << c << " - " << a << " * " << b << " == " << y << ")" << endl;
+
+        x = c;
+        y = c;
+        x.addmul(a, d);
+        y.submul(a, d);
+        cout << "assert(" << c << " + " << a << " * " << e << " == " << x << " && " << c << " - " << a << " * " << e << " == " << y << ")" << endl;
+
+        //the product cancels the accumulator exactly, and the accumulator is an operand
+        x = a * b;
+        x.submul(b, a);
+        y = a;
+        y.addmul(y, b);
+        cout << "assert(" << x << " == 0n && " << a << " + " << a << " * " << b << " == " << y << ")" << endl;
+        cout << "assert(" << a << " * " << b << " + " << c << " == " << fma(a, b, c) << ")" << endl;
+    }
+}
+
+void test_lazy()
+{
+    //sums across block boundaries, shifts by whole and partial digits, products and nested expressions
+    const size_t sizes[][3] = {{1, 1, 1}, {3, 9, 2}, {40, 30, 50}, {300, 200, 700}, {1000, 10, 600}};
+    for (auto &size : sizes)
+    {
+        BigInt a = random_bigint(size[0]);
+        BigInt b = random_bigint(size[1]);
+        BigInt c = random_bigint(size[2]);
+        BigInt d = random_bigint(size[1]);
+        size_t s = (size_t)random_int64() % (size[2] * 2 * sizeof(digit_t) * 8);
+
+        BigInt x = lazy(a) + b + c - d;
+        BigInt y = lazy(a) - b - c - d;
+        cout << "assert(" << a << " + " << b << " + " << c << " - " << d << " == " << x << " && " << a << " - " << b << " - " << c << " - " << d << " == " << y << ")" << endl;
+
+        //right shifts of magnitudes, as in test_shift
+        BigInt m = abs(b);
+        BigInt n = abs(c);
+        x = (lazy(a) << s) + (lazy(m) >> s) - c;
+        y = ((lazy(a) * b) << s) - (n >> s);
+        cout << "assert((" << a << " << 0x" << s << "n) + (" << m << " >> 0x" << s << "n) - " << c << " == " << x << " && ((" << a << " * " << b << ") << 0x" << s << "n) - (" << n << " >> 0x" << s << "n) == " << y << ")" << endl;
+
+        x = lazy(a) * b + c * lazy(d) - a;
+        y = (lazy(a) + b) * (lazy(c) - d);
+        cout << "assert(" << a << " * " << b << " + " << c << " * " << d << " - " << a << " == " << x << " && (" << a << " + " << b << ") * (" << c << " - " << d << ") == " << y << ")" << endl;
+
+        //the result is one of the operands, and exact cancellation
+        x = a;
+        x = lazy(x) + x - b;
+        y = lazy(a) - a;
+        cout << "assert(" << a << " + " << a << " - " << b << " == " << x << " && " << y << " == 0n)" << endl;
+
+        (lazy(c) - a * b).into(x);
+        cout << "assert(" << c << " - " << a << " * " << b << " == " << x << ")" << endl;
+    }
+}
+
+void test_serialize()
+{
+    //the format is fixed, whatever the limb width
+    unsigned char fixed[24];
+    BigInt("-102030405060708090a", 16).serialize(fixed, sizeof(fixed));
+    cout << "assert('";
+    for (unsigned char c : fixed)
+    {
+        cout << std::setw(2) << std::setfill('0') << (int)c;
+    }
+    cout << "' == '05000000000000000a090807060504030201000000000000')" << endl;
+
+    const size_t sizes[] = {0, 1, 3, 4, 40, 301};
+    for (size_t size : sizes)
+    {
+        BigInt a = random_bigint(size);
+
+        //aligned for the views, with a second value behind the first
+        std::vector<uint64_t> buf((a.serialized_size() + 16) / 8);
+        size_t n = a.serialize(buf.data(), buf.size() * 8);
+        BigInt(-1).serialize(reinterpret_cast<unsigned char *>(buf.data()) + n, buf.size() * 8 - n);
+        size_t used = 0;
+        BigInt b = BigInt::deserialize(buf.data(), buf.size() * 8, &used);
+        BigIntView v = BigIntView::deserialize(buf.data(), buf.size() * 8);
+        BigInt c = BigInt::deserialize(reinterpret_cast<unsigned char *>(buf.data()) + used, buf.size() * 8 - used);
+        cout << "assert(" << a << " == " << b << " && " << a << " == " << BigInt(v) << " && " << c << " == -1n)" << endl;
+        cout << "assert(" << (v == a && BigIntView(a) == b && v.bit_length() == a.bit_length() && (v < BigIntView(BigInt(1))) == (a < 1)) << ")" << endl;
+
+        //bytes most significant first read back as a hex literal, and a mixed order round trip through 3 byte words
+        BigInt m = abs(a);
+        std::vector<unsigned char> bytes(m.export_size(1));
+        m.export_bytes(bytes.data(), bytes.size(), 1, Endian::big, Endian::native);
+        cout << "assert(0x0";
+        for (unsigned char c : bytes)
+        {
+            cout << std::setw(2) << std::setfill('0') << (int)c;
+        }
+        cout << "n == " << m << ")" << endl;
+
+        std::vector<unsigned char> words(3 * (m.export_size(3) + 1));
+        m.export_bytes(words.data(), words.size() / 3, 3, Endian::little, Endian::big);
+        cout << "assert(" << m << " == " << BigInt::import_bytes(words.data(), words.size() / 3, 3, Endian::little, Endian::big) << ")" << endl;
+    }
+}
+
+void test_mapped()
+{
+    //tiles of a few digits so that small values already cross many of them
+    const std::string path = "TEST_bigint.bin";
+    const size_t sizes[][3] = {{0, 3, 2}, {1, 1, 1}, {5, 17, 3}, {40, 30, 7}, {300, 200, 64}};
+    for (auto &size : sizes)
+    {
+        BigInt a = random_bigint(size[0]);
+        BigInt b = random_bigint(size[1]);
+        MappedBigInt x = MappedBigInt::store(path + ".a", a);
+        MappedBigInt y = MappedBigInt::store(path + ".b", b);
+        BigInt sum(MappedBigInt::add(path, x.view(), y.view()).view());
+        BigInt difference(MappedBigInt::sub(path, x.view(), y.view()).view());
+        BigInt product(MappedBigInt::mul(path, x.view(), y.view(), size[2]).view());
+        BigInt zero(MappedBigInt::sub(path, x.view(), a).view());
+        cout << "assert(" << a << " + " << b << " == " << sum << " && " << a << " - " << b << " == " << difference << ")" << endl;
+        cout << "assert(" << a << " * " << b << " == " << product << " && " << zero << " == 0n && " << BigInt(MappedBigInt(path + ".a").view()) << " == " << a << ")" << endl;
+    }
+    std::remove(path.c_str());
+    std::remove((path + ".a").c_str());
+    std::remove((path + ".b").c_str());
+}
+
+void test_allocator()
+{
+    //values built on an arena, oversized blocks, values that outlive the switch back and reuse after a reset
+    //the radix powers and modulus contexts that formatting and powmod cache must not live on the arena
+    Arena arena(1024);
+    BigInt a = random_bigint(40);
+    BigInt b = random_bigint(30);
+    BigInt c = random_bigint(20000 / (sizeof(digit_t) * 8));
+    BigInt m = abs(random_bigint(8)) | 1;
+    for (int round = 0; round < 2; round++)
+    {
+        BigInt z;
+        {
+            LimbAllocator *previous = BigInt::setAllocator(&arena);
+            BigInt x = a * b + a;
+            BigInt y = x << 10000;
+            std::string s = c.to_string(10);
+            BigInt p = powmod(a, abs(b), m);
+            BigInt::setAllocator(previous);
+            cout << "assert(BigInt('" << s << "') == " << c << " && powmod(" << a << ", " << abs(b) << ", " << m << ") == " << p << ")" << endl;
+            z = y;
+            y -= x;
+            cout << "assert(" << a << " * " << b << " + " << a << " == " << x << " && (" << x << " << 10000n) - " << x << " == " << y << " && " << (arena.used() != 0) << ")" << endl;
+        }
+        arena.reset();
+        cout << "assert(" << z << " == ((" << a << " * " << b << " + " << a << ") << 10000n) && " << (arena.used() == 0) << ")" << endl;
+    }
+}
+
+void test_batch()
+{
+    //mixed signs and sizes with zeros and Karatsuba sized lanes, run twice into the same results and
+    //once in place
+    const size_t sizes[] = {0, 1, 4, 5, 17, 130};
+    const size_t n = sizeof(sizes) / sizeof(sizes[0]);
+    BigInt a[n], b[n], p[n], s[n], d[n];
+    for (size_t i = 0; i < n; i++)
+    {
+        a[i] = random_bigint(sizes[i]);
+        b[i] = random_bigint(sizes[n - 1 - i]);
+    }
+    for (int round = 0; round < 2; round++)
+    {
+        BigInt::batch_mul(a, b, p, n);
+        BigInt::batch_add(a, b, s, n);
+        BigInt::batch_sub(a, b, d, n);
+    }
+    for (size_t i = 0; i < n; i++)
+    {
+        cout << "assert(" << a[i] << " * " << b[i] << " == " << p[i] << " && " << a[i] << " + " << b[i] << " == " << s[i] << " && " << a[i] << " - " << b[i] << " == " << d[i] << ")" << endl;
+    }
+
+    BigInt c[n];
+    std::copy(a, a + n, c);
+    BigInt::batch_sub(a, b, b, n);
+    BigInt::batch_mul(a, a, a, n);
+    for (size_t i = 0; i < n; i++)
+    {
+        cout << "assert(" << d[i] << " == " << b[i] << " && " << c[i] << " * " << c[i] << " == " << a[i] << ")" << endl;
+    }
+}
+
+template <size_t Bits>
+void test_fixed_width(size_t digits)
+{
+    //operands of either sign, wider and narrower than Bits, reduced modulo 2^Bits on conversion
+    BigInt a = random_bigint(digits);
+    BigInt b = random_bigint(digits / 2 + 1);
+    FixedInt<Bits> x(a), y(b);
+    size_t s = (size_t)random_int64() % (Bits + 8);
+    cout << "M = (v) => BigInt.asUintN(" << std::dec << Bits << std::hex << ", v)" << endl;
+    cout << "assert(M(" << a << ") == " << x << " && M(" << b << ") == " << y << ")" << endl;
+    cout << "assert(M(" << a << " + " << b << ") == " << (x + y) << " && M(" << a << " - " << b << ") == " << (x - y) << ")" << endl;
+    cout << "assert(M(" << a << " * " << b << ") == " << (x * y) << ")" << endl;
+    cout << "assert(" << x << " * " << y << " == " << FixedInt<Bits>::mul_wide(x, y) << " && M(-(" << a << ")) == " << -x << ")" << endl;
+    cout << "assert(M(" << a << " << 0x" << s << "n) == " << (x << s) << " && " << x << " >> 0x" << s << "n == " << (x >> s) << ")" << endl;
+    cout << "assert(M(" << a << " & " << b << ") == " << (x & y) << " && M(" << a << " | " << b << ") == " << (x | y) << " && M(" << a << " ^ " << b << ") == " << (x ^ y) << " && M(~(" << a << ")) == " << ~x << ")" << endl;
+    cout << "assert((" << x << " < " << y << ") == " << (x < y) << " && (" << x << " >= " << y << ") == " << (x >= y) << " && " << (x == FixedInt<Bits>(BigInt(x))) << ")" << endl;
+}
+
+void test_fixed()
+{
+    //compile time construction and comparison
+    constexpr FixedInt<256> one(1), big(~0ULL);
+    static_assert(one < big && big.limb(0) == (digit_t)~0ULL && one != FixedInt<256>(), "FixedInt is not constexpr");
+
+    for (size_t i = 0; i < 4; i++)
+    {
+        test_fixed_width<256>(2 + i * 2);
+        test_fixed_width<320>(3 + i * 3);
+        test_fixed_width<1024>(10 + i * 10);
+    }
+}
+
+void test_scalar()
+{
+    //single and double digit scalars of either sign against small and multi digit values
+    ddigit_t scalars[] = {random_int64(), random_int64() >> 40, -(random_int64() >> 40), 1, -1};
+    BigInt values[] = {random_bigint(1), random_bigint(2), random_bigint(6), BigInt(random_int64() >> 40)};
+    for (auto &a : values)
+    {
+        for (auto d : scalars)
+        {
+            BigInt e(d);
+            cout << "assert(" << a << " + " << e << " == " << (a + d) << ")" << endl;
+            cout << "assert(" << a << " - " << e << " == " << (a - d) << ")" << endl;
+            cout << "assert(" << e << " - " << a << " == " << (d - a) << ")" << endl;
+            cout << "assert(" << a << " * " << e << " == " << (a * d) << ")" << endl;
+            cout << "assert((" << a << " < " << e << ") == " << (a < d ? "true" : "false") << ")" << endl;
+            cout << "assert((" << e << " >= " << a << ") == " << (d >= a ? "true" : "false") << ")" << endl;
+            std::pair<BigInt, ddigit_t> qr = divmod(a, d);
+            cout << "assert(" << a << " / " << e << " == " << qr.first << ")" << endl;
+            cout << "assert(" << a << " % " << e << " == " << BigInt(qr.second) << ")" << endl;
+        }
+        BigInt b(a);
+        cout << "assert(" << a << " + 1n == " << ++b << ")" << endl;
+        cout << "assert(" << a << " - 1n == " << --(--b) << ")" << endl;
+    }
+}
+
+void test_parse()
+{
+    cout << "function parse(s, b) { let v = 0n; for (const c of s.replace(/^[-+]/, '')) v = v * BigInt(b) + BigInt(parseInt(c, b)); return s[0] == '-' ? -v : v; }" << endl;
+
+    //short strings, basecase and divide and conquer lengths
+    const int bases[] = {2, 3, 7, 8, 10, 16, 32, 36, (int)(2 + (random_int64() & 0xffff) % 35)};
+    const size_t lengths[] = {1, 20, 300, 12000};
+    for (int base : bases)
+    {
+        for (size_t length : lengths)
+        {
+            std::string str = (random_int64() < 0 ? "-" : "") + random_digits(length, base);
+            cout << "assert(parse(\"" << str << "\", " << std::dec << base << std::hex << ") == " << BigInt(str, base) << ")" << endl;
+        }
+    }
+}
+
+void test_format()
+{
+    //single digit, basecase and divide and conquer sizes, every base checked against BigInt.prototype.toString
+    const size_t sizes[] = {1, 3, 50, 2000};
+    for (size_t size : sizes)
+    {
+        BigInt a = random_bigint(size);
+        cout << "assert(" << a << " == " << std::dec << a << "n)" << std::hex << endl;
+        for (int base = 2; base <= 36; base += (size < 100 ? 1 : 7))
+        {
+            cout << "assert((" << a << ").toString(" << std::dec << base << std::hex << ") == \"" << a.to_string(base) << "\")" << endl;
+        }
+    }
+    cout << "assert(" << BigInt() << " == 0n && \"" << BigInt().to_string(36) << "\" == \"0\")" << endl;
+}
+
+void test_div()
+{
+    //small, single digit, Knuth and Burnikel-Ziegler sized divisors
+    const size_t sizes[][2] = {{2, 1}, {4, 2}, {16, 3}, {64, 32}, {300, 17}, {400, 100}, {1200, 400}, {2500, 700}};
+    for (auto &size : sizes)
+    {
+        BigInt a = random_bigint(size[0]);
+        BigInt b = random_bigint(size[1]);
+        std::pair<BigInt, BigInt> qr = divmod(a, b);
+        cout << "assert(" << a << " / " << b << " == " << qr.first << ")" << endl;
+        cout << "assert(" << a << " % " << b << " == " << qr.second << ")" << endl;
+    }
+
+    //divisors that force the qhat correction steps
+    BigInt c(std::string(64, 'f'), 16);
+    BigInt d("80000000" + std::string(16, '0') + "ffffffff", 16);
+    cout << "assert(" << c << " / " << d << " == " << (c / d) << ")" << endl;
+    cout << "assert(" << c << " % " << d << " == " << (c % d) << ")" << endl;
+
+    ddigit_t e = random_int64();
+    ddigit_t f = random_int64() >> 40;
+    cout << "assert(" << c << " / " << BigInt(e) << " == " << (c / e) << ")" << endl;
+    cout << "assert(" << c << " % " << BigInt(f) << " == " << (c % f) << ")" << endl;
+
+    //every form of a zero divisor throws
+    BigInt zero;
+    std::function<void()> zeros[] = {[&] { divmod(c, zero); }, [&] { divmod(c, (ddigit_t)0); }, [&] { c / zero; }, [&] { c % (ddigit_t)0; }, [&] { BigInt(c) /= (ddigit_t)0; }, [&] { BigInt(c) %= zero; }};
+    size_t thrown = 0;
+    for (auto &z : zeros)
+    {
+        try
+        {
+            z();
+        }
+        catch (const std::domain_error &)
+        {
+            thrown++;
+        }
+    }
+    cout << "assert(" << thrown << " == 6)" << endl;
+}
+
+void test_pow()
+{
+    cout << "function powmod(b, e, m) { let r = 1n % m; b = (b % m + m) % m; for (; e > 0n; e >>= 1n, b = b * b % m) if (e & 1n) r = r * b % m; return r; }" << endl;
+
+    BigInt a = random_bigint(3);
+    cout << "assert((" << a << ") ** 0n == " << pow(a, 0) << ")" << endl;
+    cout << "assert((" << a << ") ** 7n == " << pow(a, 7) << ")" << endl;
+    cout << "assert((" << a << ") ** 100n == " << pow(a, 100) << ")" << endl;
+
+    //odd moduli take the Montgomery path, even ones Barrett, the largest runs on the Karatsuba spans
+    const size_t sizes[] = {1, 3, 32, 150};
+    for (size_t size : sizes)
+    {
+        for (int odd = 0; odd < 2; odd++)
+        {
+            BigInt m = abs(random_bigint(size));
+            m = m - m % 2 + odd;
+            ModContext ctx(m);
+
+            BigInt b = random_bigint(size + 1);
+            BigInt e = abs(random_bigint(size));
+            BigInt f = abs(random_bigint(1)) >> 40;
+            cout << "assert(powmod(" << b << ", " << e << ", " << m << ") == " << ctx.powmod(b, e) << ")" << endl;
+            cout << "assert(powmod(" << b << ", " << f << ", " << m << ") == " << powmod(b, f, m) << ")" << endl;
+            cout << "assert(powmod(" << b << ", 0n, " << m << ") == " << ctx.powmod(b, 0) << ")" << endl;
+            if (odd)
+            {
+                cout << "assert(powmod(" << b << ", " << e << ", " << m << ") == " << ctx.powmodSec(b, e) << ")" << endl;
+                cout << "assert(powmod(" << b << ", " << f << ", " << m << ") == " << ctx.powmodSec(b, f) << ")" << endl;
+                //bases of at most n digits, possibly above m, skip the reduction
+                BigInt c = abs(random_bigint(size));
+                cout << "assert(powmod(" << c << ", " << e << ", " << m << ") == " << ctx.powmodSec(c, e) << ")" << endl;
+                cout << "assert(powmod(" << m - 1 << ", " << f << ", " << m << ") == " << ctx.powmodSec(m - 1, f) << ")" << endl;
+            }
+        }
+    }
+    cout << "assert(powmod(" << a << ", 5n, 1n) == " << powmod(a, 5, 1) << ")" << endl;
+
+    //negative exponents, even moduli for powmodSec and non-positive moduli are rejected
+    BigInt m = abs(random_bigint(3)) | 1;
+    ModContext odd(m), even(m + 1);
+    std::function<void()> invalid[] = {[&] { odd.powmod(a, -m); }, [&] { odd.powmodSec(a, -m); }, [&] { even.powmodSec(a, m); },
+                                       [&] { powmod(a, m, BigInt()); }, [&] { BigInt::modinv(a, BigInt()); }, [&] { BigInt::modinv(a, -m); }};
+    size_t thrown = 0;
+    for (auto &f : invalid)
+    {
+        try
+        {
+            f();
+        }
+        catch (const std::invalid_argument &)
+        {
+            thrown++;
+        }
+    }
+    cout << "assert(" << thrown << " == 6)" << endl;
+}
+
+void test_modular()
+{
+    //every operation runs in the form of the context and is checked after converting back
+    const size_t sizes[] = {1, 4, 150};
+    for (size_t size : sizes)
+    {
+        for (int odd = 0; odd < 2; odd++)
+        {
+            BigInt m = abs(random_bigint(size));
+            m = m - m % 2 + odd;
+            ModContext ctx(m);
+
+            BigInt a = random_bigint(size + 1);
+            BigInt b = abs(random_bigint(size)) % m;
+            BigInt x = ctx.toMontgomery(a);
+            BigInt y = ctx.toMontgomery(b);
+            cout << "m = " << m << "; a = " << a << "; b = " << b << ";" << endl;
+            cout << "assert(((a % m + m) % m) == " << ctx.fromMontgomery(x) << ")" << endl;
+            cout << "assert(((a * b % m + m) % m) == " << ctx.fromMontgomery(ctx.mulmod(x, y)) << ")" << endl;
+            cout << "assert(((a * a % m + m) % m) == " << ctx.fromMontgomery(ctx.sqrmod(x)) << ")" << endl;
+            cout << "assert((((a + b) % m + m) % m) == " << ctx.fromMontgomery(ctx.addmod(x, y)) << ")" << endl;
+            cout << "assert((((a - b) % m + m) % m) == " << ctx.fromMontgomery(ctx.submod(x, y)) << ")" << endl;
+            try
+            {
+                BigInt z = ctx.fromMontgomery(ctx.inv(x));
+                cout << "assert((((a * " << z << ") % m + m) % m) == 1n % m)" << endl;
+            }
+            catch (const std::invalid_argument &)
+            {
+                //not coprime, the gcd check below fails if that was wrong
+                cout << "{ let u = (a % m + m) % m, v = m; while (v) [u, v] = [v, u % v]; assert(u != 1n) }" << endl;
+            }
+        }
+    }
+
+    //zero and negative moduli are rejected
+    const BigInt moduli[] = {BigInt(), BigInt(-7), -abs(random_bigint(4))};
+    size_t thrown = 0;
+    for (auto &m : moduli)
+    {
+        try
+        {
+            ModContext ctx(m);
+        }
+        catch (const std::invalid_argument &)
+        {
+            thrown++;
+        }
+    }
+    cout << "assert(" << thrown << " == 3)" << endl;
+}
+
+void test_gcd()
+{
+    cout << "function gcd(a, b) { a = a < 0n ? -a : a; b = b < 0n ? -b : b; while (b) [a, b] = [b, a % b]; return a; }" << endl;
+
+    //binary, Lehmer and half GCD sizes, with a common factor so that the result is not trivially one
+    const size_t sizes[][2] = {{1, 1}, {2, 1}, {5, 3}, {40, 40}, {300, 280}, {600, 20}};
+    for (auto &size : sizes)
+    {
+        BigInt c = random_bigint(size[1] / 4 + 1);
+        BigInt a = random_bigint(size[0]) * c;
+        BigInt b = random_bigint(size[1]) * c;
+        BigInt x, y;
+        BigInt g = gcdext(a, b, x, y);
+        cout << "a = " << a << "; b = " << b << ";" << endl;
+        cout << "assert(gcd(a, b) == " << gcd(a, b) << " && " << g << " == gcd(a, b))" << endl;
+        cout << "assert(a * " << x << " + b * " << y << " == gcd(a, b))" << endl;
+        cout << "assert((a * b < 0n ? -a * b : a * b) / gcd(a, b) == " << lcm(a, b) << ")" << endl;
+    }
+
+    BigInt x, y;
+    BigInt a = random_bigint(3);
+    BigInt g = gcdext(a, 0, x, y);
+    cout << "assert(" << g << " == gcd(" << a << ", 0n) && " << x << " * " << a << " == " << g << ")" << endl;
+    cout << "assert(" << gcd(BigInt(), BigInt()) << " == 0n && " << lcm(a, 0) << " == 0n)" << endl;
+
+    //a prime modulus, so that every non-zero residue has an inverse
+    BigInt p("170141183460469231731687303715884105727");
+    BigInt i = modinv(a, p);
+    cout << "assert(((" << a << " * " << i << ") % " << p << " + " << p << ") % " << p << " == 1n)" << endl;
+}
+
 double example(unsigned int num)
 {
-    uint64_t count = 0;
-    BigInt c = BigInt(random_hex(256 * 1024 * sizeof(digit_t) * 2), 16) * (random_int64() > 0 ? 1 : -1);
-    BigInt d = BigInt(random_hex(256 * 1024 * sizeof(digit_t) * 2), 16) * (random_int64() > 0 ? 1 : -1);
+    typedef BigInt (*mul_t)(const BigInt &, const BigInt &);
+    const char *names[] = {"baseMul", "karatsubaMul", "toom3Mul", "toom4Mul", "nttMul", "mul"};
+    mul_t tiers[] = {
+        BigInt::baseMul,
+        BigInt::karatsubaMul,
+        BigInt::toom3Mul,
+        BigInt::toom4Mul,
+        BigInt::nttMul,
+        BigInt::mul,
+    };
+    const size_t ntiers = sizeof(tiers) / sizeof(tiers[0]);
+    //a tier is dropped from larger sizes once a single product takes longer than this
+    const double budget = 2e6;
+    bool enabled[ntiers] = {true, true, true, true, true, true};
+
+    double last = 0;
+    for (size_t limbs = 64; limbs <= 256 * 1024; limbs *= 2)
+    {
+        BigInt c = random_bigint(limbs);
+        BigInt d = random_bigint(limbs);
+        cout << "Mul: " << limbs << " limbs";
+        for (size_t t = 0; t < ntiers; t++)
+        {
+            if (!enabled[t])
+            {
+                continue;
+            }
+            std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+            for (size_t i = 0; i < num; i++)
+            {
+                BigInt m = tiers[t](c, d);
+            }
+            std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+            std::chrono::microseconds duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+            last = (double)duration.count() / num;
+            cout << ", " << names[t] << " " << last << "us";
+            enabled[t] = last < budget;
+        }
+        cout << endl;
+    }
+
+    //parallel multiply speedup over the thread count
+    BigInt c = random_bigint(64 * 1024);
+    BigInt d = random_bigint(64 * 1024);
+    double single = 0;
+    for (size_t threads = 1; threads <= std::max(4u, std::thread::hardware_concurrency()); threads *= 2)
+    {
+        BigInt::setThreads(threads);
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < num; i++)
+        {
+            BigInt m = c * d;
+        }
+        std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+        std::chrono::microseconds duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+        last = (double)duration.count() / num;
+        single = threads == 1 ? last : single;
+        cout << "Mul: " << 64 * 1024 << " limbs on " << threads << " threads in " << last << "us, speedup " << single / last << endl;
+    }
+    BigInt::setThreads(1);
+    return last;
+}
+
+double allocations_per_expression(const char *expr, std::function<BigInt()> f, unsigned int num)
+{
+    size_t count = allocations;
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < num; i++)
+    {
+        BigInt r = f();
+    }
+    std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+    std::chrono::nanoseconds duration = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+    count = allocations - count;
+    cout << "Allocations: " << (double)count / num << " per " << expr << " in " << (double)duration.count() / num << "ns" << endl;
+    return (double)count / num;
+}
+
+double parse_throughput(int base, size_t length)
+{
+    std::string str = random_digits(length, base);
+    unsigned int num = std::max<size_t>(1, 1000000 / length);
     std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
     for (size_t i = 0; i < num; i++)
     {
+        BigInt r(str, base);
+    }
+    std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+    std::chrono::microseconds duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+    double mbs = (double)length * num / duration.count();
+    cout << "Parse: " << length << " characters in base " << base << " at " << mbs << "MB/s" << endl;
+    return mbs;
+}
 
-        BigInt m = (c * d);
+double format_throughput(int base, size_t length)
+{
+    BigInt a(random_digits(length, base), base);
+    unsigned int num = std::max<size_t>(1, 1000000 / length);
+    a.to_string(base); //warm the cached radix powers
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < num; i++)
+    {
+        std::string r = a.to_string(base);
     }
     std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
     std::chrono::microseconds duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-    count += duration.count();
-    cout << "Execution time: " << num << " BigInt Mul in " << (double)count / 1e6 << "s. " << (double)count / num << "us per BigInt Mul" << endl;
-    return (double)count / num;
+    double mbs = (double)length * num / duration.count();
+    cout << "Format: " << length << " characters in base " << base << " at " << mbs << "MB/s" << endl;
+    return mbs;
+}
+
+double shift_throughput(size_t digits)
+{
+    BigInt a = BigInt(random_hex(digits * sizeof(digit_t) * 2), 16);
+    unsigned int num = std::max<size_t>(1, 10000000 / digits);
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < num; i++)
+    {
+        a <<= (size_t)13;
+        a >>= (size_t)13;
+    }
+    std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+    std::chrono::microseconds duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+    double mbs = (double)digits * sizeof(digit_t) * 2 * num / duration.count();
+    cout << "Shift: " << digits << " digits at " << mbs << "MB/s" << endl;
+    return mbs;
+}
+
+double serialize_throughput(size_t digits)
+{
+    BigInt a = BigInt(random_hex(digits * sizeof(digit_t) * 2), 16);
+    std::vector<uint64_t> buf(a.serialized_size() / 8);
+    unsigned int num = std::max<size_t>(1, 10000000 / digits);
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < num; i++)
+    {
+        a.serialize(buf.data(), buf.size() * 8);
+        a = BigInt::deserialize(buf.data(), buf.size() * 8);
+    }
+    std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+    std::chrono::microseconds duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+    double mbs = (double)digits * sizeof(digit_t) * 2 * num / duration.count();
+    cout << "Serialize: " << digits << " digits at " << mbs << "MB/s" << endl;
+    return mbs;
+}
+
+//operations per second and thread on short lived values of a few digits, with a per thread arena reset
+//after every request of 100 operations or with the default allocator
+double allocator_throughput(size_t threads, bool arena)
+{
+    BigInt a = BigInt(random_hex(8 * sizeof(digit_t) * 2), 16);
+    BigInt b = BigInt(random_hex(6 * sizeof(digit_t) * 2), 16);
+    const size_t requests = 2000;
+    std::vector<std::thread> pool;
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    for (size_t t = 0; t < threads; t++)
+    {
+        pool.emplace_back([&] {
+            Arena local;
+            LimbAllocator *previous = BigInt::setAllocator(arena ? &local : nullptr);
+            for (size_t r = 0; r < requests; r++)
+            {
+                {
+                    BigInt x = a;
+                    for (size_t i = 0; i < 50; i++)
+                    {
+                        BigInt y = x * b + a;
+                        x = y >> 64;
+                    }
+                }
+                local.reset();
+            }
+            BigInt::setAllocator(previous);
+        });
+    }
+    for (std::thread &t : pool)
+    {
+        t.join();
+    }
+    std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+    std::chrono::microseconds duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+    double ops = 100.0 * requests * 1e6 / duration.count();
+    cout << "Allocator: " << threads << " threads, " << (arena ? "arena " : "default ") << ops << " ops/s per thread" << endl;
+    return ops;
+}
+
+//products per second of many independent pairs, one operator* each against batch_mul into reused results
+double batch_throughput(size_t digits)
+{
+    const size_t n = 10000;
+    static BigInt a[n], b[n], r[n];
+    for (size_t i = 0; i < n; i++)
+    {
+        a[i] = BigInt(random_hex(digits * sizeof(digit_t) * 2), 16);
+        b[i] = BigInt(random_hex(digits * sizeof(digit_t) * 2), 16);
+    }
+    double rates[2];
+    for (size_t k = 0; k < 2; k++)
+    {
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+        for (size_t round = 0; round < 20; round++)
+        {
+            if (k == 0)
+            {
+                for (size_t i = 0; i < n; i++)
+                {
+                    r[i] = a[i] * b[i];
+                }
+            }
+            else
+            {
+                BigInt::batch_mul(a, b, r, n);
+            }
+        }
+        std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+        rates[k] = 20.0 * n * 1e6 / std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    }
+    cout << "Batch: " << digits << " digit products, operator* " << rates[0] << "/s, batch_mul " << rates[1] << "/s" << endl;
+    return rates[1];
+}
+
+//multiply-accumulate steps per second on Bits wide values, as BigInt reduced by a mask and as FixedInt
+template <size_t Bits>
+double fixed_throughput()
+{
+    const size_t n = 1000000;
+    BigInt mask = (BigInt(1) << Bits) - 1;
+    BigInt a(random_hex(Bits / 4), 16), b(random_hex(Bits / 4), 16);
+    FixedInt<Bits> x(a), y(b);
+    double rates[2];
+    for (size_t k = 0; k < 2; k++)
+    {
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < n; i++)
+        {
+            if (k == 0)
+            {
+                a = (a * b + b) & mask;
+            }
+            else
+            {
+                x = x * y + y;
+            }
+        }
+        std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+        rates[k] = n * 1e6 / std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    }
+    cout << "Fixed: " << Bits << " bits, BigInt " << rates[0] << "/s, FixedInt " << rates[1] << "/s" << (a == BigInt(x) ? "" : " (mismatch)") << endl;
+    return rates[1];
+}
+
+double powmod_latency(size_t bits)
+{
+    //full size exponents against a fixed odd modulus with its context reused, and an even one for Barrett
+    BigInt m = BigInt(random_hex(bits / 4), 16);
+    m = m - m % 2 + 1;
+    BigInt b = BigInt(random_hex(bits / 4), 16);
+    BigInt e = BigInt(random_hex(bits / 4), 16);
+    ModContext odd(m);
+    ModContext even(m - 1);
+
+    std::function<BigInt()> runs[] = {[&] { return odd.powmod(b, e); }, [&] { return odd.powmodSec(b, e); }, [&] { return even.powmod(b, e); }};
+    double us[3];
+    for (size_t k = 0; k < 3; k++)
+    {
+        unsigned int num = 0;
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+        std::chrono::high_resolution_clock::time_point end = start;
+        while (num < 3 || end - start < std::chrono::milliseconds(500))
+        {
+            BigInt r = runs[k]();
+            num++;
+            end = std::chrono::high_resolution_clock::now();
+        }
+        us[k] = (double)std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / num;
+    }
+    cout << "Powmod: " << bits << " bits in " << us[0] << "us, constant time " << us[1] << "us, even modulus " << us[2] << "us" << endl;
+    return us[0];
+}
+
+void benchmark()
+{
+    BigInt a = BigInt(random_hex(64 * sizeof(digit_t) * 2), 16);
+    BigInt b = BigInt(random_hex(64 * sizeof(digit_t) * 2), 16);
+    BigInt c = BigInt(random_hex(64 * sizeof(digit_t) * 2), 16);
+    BigInt d = BigInt(random_hex(32 * sizeof(digit_t) * 2), 16);
+
+    allocations_per_expression("a + b + c - d", [&] { return a + b + c - d; }, 10000);
+    allocations_per_expression("lazy(a) + b + c - d", [&] { return BigInt(lazy(a) + b + c - d); }, 10000);
+    allocations_per_expression("a * b + c * d", [&] { return a * b + c * d; }, 10000);
+    allocations_per_expression("(a * b).addmul(c, d)", [&] { return (a * b).addmul(c, d); }, 10000);
+    allocations_per_expression("(a << 7) + (b >> 3)", [&] { return (a << 7) + (b >> 3); }, 10000);
+    allocations_per_expression("(a & b) | (c ^ d)", [&] { return (a & b) | (c ^ d); }, 10000);
+    allocations_per_expression("-(a - b) * 3 + 1", [&] { return -(a - b) * 3 + 1; }, 10000);
+    allocations_per_expression("a / d + a % d", [&] { return a / d + a % d; }, 10000);
+    allocations_per_expression("a * 10 + 7", [&] { return a * 10 + 7; }, 10000);
+    allocations_per_expression("a * a", [&] { return a * a; }, 10000);
+    allocations_per_expression("a * b", [&] { return a * b; }, 10000);
+    allocations_per_expression("++(a + 1) - 1 == b", [&] { return BigInt(++(a + 1) - 1 == b); }, 10000);
+    allocations_per_expression("a / 1000000007 + a % -10", [&] { return a / 1000000007 + a % -10; }, 10000);
+
+    //values that fit the inline storage should never touch the heap
+    BigInt s = BigInt(random_hex(2 * sizeof(digit_t) * 2), 16);
+    BigInt t = BigInt(random_hex(4 * sizeof(digit_t) * 2), 16);
+    BigInt u = BigInt(random_hex(3 * sizeof(digit_t) * 2), 16);
+    allocations_per_expression("s * t + u (small)", [&] { return s * t + u; }, 100000);
+    allocations_per_expression("(s * t - u) / u (small)", [&] { return (s * t - u) / u; }, 100000);
+    allocations_per_expression("(s << 35) % t (small)", [&] { return (s << 35) % t; }, 100000);
+    allocations_per_expression("s * 10 + 7 (small)", [&] { return s * 10 + 7; }, 100000);
+
+    parse_throughput(10, 1000);
+    parse_throughput(10, 100000);
+    parse_throughput(10, 1000000);
+    parse_throughput(16, 1000000);
+    parse_throughput(36, 1000000);
+
+    format_throughput(10, 1000);
+    format_throughput(10, 100000);
+    format_throughput(10, 1000000);
+    format_throughput(16, 1000000);
+
+    shift_throughput(64);
+    shift_throughput(100000);
+
+    serialize_throughput(64);
+    serialize_throughput(100000);
+
+    batch_throughput(256 / (sizeof(digit_t) * 8));
+    batch_throughput(1024 / (sizeof(digit_t) * 8));
+
+    fixed_throughput<256>();
+    fixed_throughput<1024>();
+
+    allocator_throughput(1, false);
+    allocator_throughput(1, true);
+    allocator_throughput(4, false);
+    allocator_throughput(4, true);
+
+    //a fixed modulus reused across operations, as in Montgomery form arithmetic loops
+    BigInt m = BigInt(random_hex(2048 / 4), 16);
+    ModContext ctx(m - m % 2 + 1);
+    BigInt x = ctx.toMontgomery(a);
+    BigInt y = ctx.toMontgomery(b);
+    allocations_per_expression("ctx.mulmod(x, y) (2048 bits)", [&] { return ctx.mulmod(x, y); }, 10000);
+    allocations_per_expression("ctx.addmod(x, y) (2048 bits)", [&] { return ctx.addmod(x, y); }, 10000);
+
+    powmod_latency(2048);
+    powmod_latency(4096);
+
+    example(1);
 }
 
 int main(int argc, char const *argv[])
@@ -54,6 +1036,12 @@ int main(int argc, char const *argv[])
 
     gen.seed(time(0));
 
+    if (argc > 1 && std::string(argv[1]) == "bench")
+    {
+        benchmark();
+        return 0;
+    }
+
     BigInt a(random_int64());
     BigInt b(random_int64());
     BigInt c = BigInt(random_hex(256 * 1024 * sizeof(digit_t) * 2), 16) * (random_int64() > 0 ? 1 : -1);
@@ -77,6 +1065,9 @@ else:\n\
          << endl;
 #endif
 
+    //BigInt values print as JavaScript literals on hex streams
+    cout << std::hex;
+
     BigInt e = BigInt(random_hex(8 * sizeof(digit_t) * 2), 16) * (random_int64() > 0 ? 1 : -1);
     cout << "const assert = require('assert');" <<endl;
     for (size_t i = 0; i < 256; i++)
@@ -85,5 +1076,24 @@ else:\n\
         cout << "assert(" << e << "<< 0x" << i << "n == " << f << ")" << endl;
     }
 
+    test_arith();
+    test_shift();
+    test_bitwise();
+    test_mul();
+    test_scalar();
+    test_addmul();
+    test_lazy();
+    test_serialize();
+    test_mapped();
+    test_allocator();
+    test_batch();
+    test_fixed();
+    test_div();
+    test_pow();
+    test_modular();
+    test_gcd();
+    test_parse();
+    test_format();
+
     return 0;
 }
@@ -1,14 +1,137 @@
 #include "bigint.hpp"
 
 #include <cctype>
-#include <iomanip>
+#include <deque>
 #include <string>
 #include <algorithm>
 #include <cassert>
+#include <tuple>
+#include <stdexcept>
+#include <vector>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+//file backed values map their files through POSIX
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define BIGINT_MMAP
+#endif
+
+//64 bit limbs on x86-64 chain carries through adc/sbb, the double width products already compile to mul/mulx
+#if BIGINT_DIGIT_BIT == 64 && defined(__x86_64__)
+#include <x86intrin.h>
+#define BIGINT_CARRY_INTRINSICS
+#endif
 
 namespace bigint
 {
 
+//magnitude of v, negated as unsigned so that the most negative value does not overflow
+static inline uddigit_t magnitude(ddigit_t v)
+{
+    return v >= 0 ? (uddigit_t)v : -(uddigit_t)v;
+}
+
+static thread_local LimbAllocator *threadAllocator = nullptr;
+
+LimbAllocator *limbAllocator()
+{
+    return threadAllocator;
+}
+
+LimbAllocator *BigInt::setAllocator(LimbAllocator *a)
+{
+    std::swap(a, threadAllocator);
+    return a;
+}
+
+//per thread caches outlive the allocator of the call that fills them, so they take operator new storage
+class CacheAllocation
+{
+  private:
+    LimbAllocator *previous;
+
+  public:
+    CacheAllocation() : previous(BigInt::setAllocator(nullptr)) {}
+    ~CacheAllocation() { BigInt::setAllocator(this->previous); }
+};
+
+//chunk headers and blocks keep the alignment of operator new
+static inline size_t alignUp(size_t n)
+{
+    const size_t a = alignof(std::max_align_t);
+    return (n + a - 1) & ~(a - 1);
+}
+
+Arena::Arena(size_t chunkSize) : first(nullptr), current(nullptr), top(nullptr), limit(nullptr), chunkSize(chunkSize), bytes(0)
+{
+}
+
+Arena::~Arena()
+{
+    Chunk *c = this->first;
+    while (c != nullptr)
+    {
+        Chunk *next = c->next;
+        ::operator delete(c);
+        c = next;
+    }
+}
+
+void *Arena::allocate(size_t n)
+{
+    n = alignUp(std::max<size_t>(n, 1));
+    if ((size_t)(this->limit - this->top) < n)
+    {
+        //the next chunk kept from before the last reset when it is large enough, a new one otherwise
+        Chunk *c = this->current != nullptr ? this->current->next : this->first;
+        if (c == nullptr || c->size < n)
+        {
+            size_t size = std::max(this->chunkSize, n);
+            Chunk *fresh = static_cast<Chunk *>(::operator new(alignUp(sizeof(Chunk)) + size));
+            fresh->next = c;
+            fresh->size = size;
+            if (this->current != nullptr)
+            {
+                this->current->next = fresh;
+            }
+            else
+            {
+                this->first = fresh;
+            }
+            c = fresh;
+        }
+        this->current = c;
+        this->top = reinterpret_cast<unsigned char *>(c) + alignUp(sizeof(Chunk));
+        this->limit = this->top + c->size;
+    }
+    void *p = this->top;
+    this->top += n;
+    this->bytes += n;
+    return p;
+}
+
+//blocks are only reclaimed in bulk by reset
+void Arena::deallocate(void *, size_t)
+{
+}
+
+void Arena::reset()
+{
+    this->current = this->first;
+    this->top = this->first != nullptr ? reinterpret_cast<unsigned char *>(this->first) + alignUp(sizeof(Chunk)) : nullptr;
+    this->limit = this->first != nullptr ? this->top + this->first->size : nullptr;
+    this->bytes = 0;
+}
+
 BigInt::BigInt()
 {
     this->sign = BigInt::SIGN_POS;
@@ -17,512 +140,4275 @@ BigInt::BigInt()
 BigInt::BigInt(ddigit_t v)
 {
     this->sign = v >= 0 ? BigInt::SIGN_POS : BigInt::SIGN_NEG;
-    if (v != 0)
+    uddigit_t m = magnitude(v);
+    while (m != 0)
+    {
+        this->numeral.push_back(m & BigInt::DIGIT_MAX);
+        m >>= BigInt::DIGIT_BIT;
+    }
+}
+//value of a digit character in bases up to 36, 36 for anything else
+static inline int digitValue(char c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'z')
+    {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'Z')
+    {
+        return c - 'A' + 10;
+    }
+    return 36;
+}
+
+//number of characters k whose value always fits in a digit, and base^k
+static inline size_t charsPerDigit(int base, digit_t &big)
+{
+    size_t k = 1;
+    big = base;
+    while ((uddigit_t)big * base <= (digit_t)-1)
+    {
+        big *= base;
+        k++;
+    }
+    return k;
+}
+
+BigInt::BigInt(const std::string &s, int base)
+{
+    this->sign = BigInt::SIGN_POS;
+
+    if (base < 2 || base > 36)
+    {
+        throw std::invalid_argument("BigInt: base must be between 2 and 36");
+    }
+
+    const char *p = s.data();
+    const char *end = p + s.size();
+    if (p != end && (*p == '-' || *p == '+'))
+    {
+        this->sign = *p == '-' ? BigInt::SIGN_NEG : BigInt::SIGN_POS;
+        p++;
+    }
+    //remove leading zeros
+    while (p != end && *p == '0')
+    {
+        p++;
+    }
+    for (const char *c = p; c != end; c++)
+    {
+        if (digitValue(*c) >= base)
+        {
+            throw std::invalid_argument("BigInt: invalid digit");
+        }
+    }
+
+    int sign = this->sign;
+    *this = BigInt::parse(p, end - p, base);
+    this->sign = this->numeral.size() != 0 ? sign : BigInt::SIGN_POS;
+}
+
+BigInt::BigInt(const std::string &s) : BigInt(s, 10)
+{
+}
+
+BigInt BigInt::parse(const char *s, size_t length, int base)
+{
+    if ((base & (base - 1)) == 0)
+    {
+        return BigInt::parsePow2(s, length, base);
+    }
+
+    digit_t big;
+    size_t k = charsPerDigit(base, big);
+    if (length <= k * BigInt::PARSE_THRESHOLD)
+    {
+        return BigInt::parseBase(s, length, base);
+    }
+
+    return BigInt::parseDC(s, length, base);
+}
+
+//power of two bases map straight onto the bits of the digits, least significant character first
+BigInt BigInt::parsePow2(const char *s, size_t length, int base)
+{
+    size_t bits = 0;
+    while ((1 << bits) < base)
+    {
+        bits++;
+    }
+
+    BigInt tmp;
+    tmp.numeral.reserve(length * bits / BigInt::DIGIT_BIT + 1);
+
+    uddigit_t acc = 0;
+    size_t n = 0;
+    for (size_t i = length - 1; i < length; i--)
+    {
+        acc |= (uddigit_t)digitValue(s[i]) << n;
+        n += bits;
+        if (n >= BigInt::DIGIT_BIT)
+        {
+            tmp.numeral.push_back(acc & BigInt::DIGIT_MAX);
+            acc >>= BigInt::DIGIT_BIT;
+            n -= BigInt::DIGIT_BIT;
+        }
+    }
+    if (n != 0)
+    {
+        tmp.numeral.push_back(acc);
+    }
+    return tmp.trim();
+}
+
+//schoolbook conversion, one digit worth of characters at a time: tmp = tmp * base^k + chunk
+BigInt BigInt::parseBase(const char *s, size_t length, int base)
+{
+    digit_t big;
+    size_t k = charsPerDigit(base, big);
+
+    BigInt tmp;
+    tmp.numeral.reserve(length / k + 1);
+
+    //the leading chunk takes the characters left over
+    size_t n = length % k ? length % k : k;
+    for (size_t i = 0; i < length; i += n, n = k)
+    {
+        digit_t v = 0;
+        for (size_t j = 0; j < n; j++)
+        {
+            v = v * base + digitValue(s[i + j]);
+        }
+        tmp.mulAbs(big);
+        tmp.addAbs(v);
+    }
+    return tmp;
+}
+
+//divide and conquer: split off the low k * 2^i characters and combine with the cached power base^(k * 2^i)
+BigInt BigInt::parseDC(const char *s, size_t length, int base)
+{
+    digit_t big;
+    size_t k = charsPerDigit(base, big);
+    if (length <= k * BigInt::PARSE_THRESHOLD)
+    {
+        return BigInt::parseBase(s, length, base);
+    }
+
+    size_t i = 0;
+    while ((k << (i + 1)) < length)
+    {
+        i++;
+    }
+
+    size_t low = k << i;
+    BigInt tmp = BigInt::parseDC(s, length - low, base);
+    tmp *= BigInt::radixPower(base, i);
+    tmp += BigInt::parseDC(s + length - low, low, base);
+    return tmp;
+}
+
+BigInt::BigInt(const BigInt &o)
+{
+    this->sign = o.sign;
+    this->numeral = o.numeral;
+}
+
+BigInt::BigInt(BigInt &&o) noexcept
+{
+    this->sign = o.sign;
+    this->numeral = std::move(o.numeral);
+    o.sign = BigInt::SIGN_POS;
+}
+
+BigInt::BigInt(const BigIntView &v)
+{
+    this->sign = v.negative() ? BigInt::SIGN_NEG : BigInt::SIGN_POS;
+    this->numeral.assign(v.data(), v.data() + v.size());
+}
+
+BigInt &BigInt::operator=(const BigInt &o)
+{
+    this->sign = o.sign;
+    this->numeral = o.numeral;
+    return *this;
+}
+
+BigInt &BigInt::operator=(BigInt &&o) noexcept
+{
+    this->sign = o.sign;
+    this->numeral = std::move(o.numeral);
+    o.sign = BigInt::SIGN_POS;
+    return *this;
+}
+
+BigInt::~BigInt()
+{
+}
+
+ddigit_t BigInt::cmp(const BigInt &l, const BigInt &r)
+{
+    if (l.sign != r.sign)
+    {
+        return l.sign;
+    }
+    return l.sign * BigInt::cmpAbs(l, r);
+}
+
+ddigit_t BigInt::cmp(const BigInt &l, ddigit_t r)
+{
+    int sign = r >= 0 ? BigInt::SIGN_POS : BigInt::SIGN_NEG;
+    if (l.sign != sign)
+    {
+        return l.sign;
+    }
+    return l.sign * BigInt::cmpAbs(l, magnitude(r));
+}
+
+int BigInt::cmpAbs(const BigInt &l, const BigInt &r)
+{
+    //Assuming that no leading zero are allowed.
+    if (l.numeral.size() != r.numeral.size())
+    {
+        return l.numeral.size() < r.numeral.size() ? -1 : 1;
+    }
+
+    size_t length = l.numeral.size();
+    for (size_t i = length - 1; i < length; i--)
+    {
+
+        if (l.numeral[i] != r.numeral[i])
+        {
+            return l.numeral[i] < r.numeral[i] ? -1 : 1;
+        }
+    }
+    //both l and r are equal
+    return 0;
+}
+
+int BigInt::cmpAbs(const BigInt &l, uddigit_t r)
+{
+    size_t length = 0;
+    for (uddigit_t t = r; t != 0; t >>= BigInt::DIGIT_BIT)
+    {
+        length++;
+    }
+    if (l.numeral.size() != length)
+    {
+        return l.numeral.size() < length ? -1 : 1;
+    }
+
+    for (size_t i = length - 1; i < length; i--)
+    {
+        digit_t d = (r >> (i * BigInt::DIGIT_BIT)) & BigInt::DIGIT_MAX;
+        if (l.numeral[i] != d)
+        {
+            return l.numeral[i] < d ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+//Limb kernels over raw digit arrays. r may be the same array as a or b in addN and subN, every
+//other kernel needs r distinct from its inputs or equal to a. The x86-64 variants are picked once
+//at run time when the processor has ADX and BMI2, or AVX2 for the shifts, the portable ones work at any limb width.
+//mul1 has a single carry chain and the portable loop already compiles to mul/adc, so it has no variant.
+
+static digit_t addNGeneric(digit_t *r, const digit_t *a, const digit_t *b, size_t n)
+{
+    uddigit_t c = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        c += (uddigit_t)a[i] + b[i];
+        r[i] = (digit_t)c;
+        c >>= (sizeof(digit_t) * CHAR_BIT);
+    }
+    return (digit_t)c;
+}
+
+static digit_t subNGeneric(digit_t *r, const digit_t *a, const digit_t *b, size_t n)
+{
+    digit_t borrow = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        digit_t x = a[i];
+        digit_t y = b[i];
+        digit_t d = x - y;
+        r[i] = d - borrow;
+        borrow = (x < y) | (d < borrow);
+    }
+    return borrow;
+}
+
+//r = a * b, returns the high digit
+static digit_t mul1Generic(digit_t *r, const digit_t *a, size_t n, digit_t b)
+{
+    uddigit_t carry = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        carry += (uddigit_t)a[i] * b;
+        r[i] = (digit_t)carry;
+        carry >>= (sizeof(digit_t) * CHAR_BIT);
+    }
+    return (digit_t)carry;
+}
+
+//r += a * b, returns the carry digit
+static digit_t addMul1Generic(digit_t *r, const digit_t *a, size_t n, digit_t b)
+{
+    uddigit_t carry = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        carry += (uddigit_t)a[i] * b + r[i];
+        r[i] = (digit_t)carry;
+        carry >>= (sizeof(digit_t) * CHAR_BIT);
+    }
+    return (digit_t)carry;
+}
+
+//r -= a * b, returns the borrow digit
+static digit_t subMul1Generic(digit_t *r, const digit_t *a, size_t n, digit_t b)
+{
+    digit_t borrow = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        uddigit_t p = (uddigit_t)a[i] * b + borrow;
+        digit_t lo = (digit_t)p;
+        borrow = (digit_t)(p >> (sizeof(digit_t) * CHAR_BIT)) + (r[i] < lo);
+        r[i] -= lo;
+    }
+    return borrow;
+}
+
+//r[0..n) = a[0..n) << s with 0 < s < DIGIT_BIT, returns the bits shifted out of the top.
+//Runs downwards, so r may sit at or above a.
+static digit_t lshiftGeneric(digit_t *r, const digit_t *a, size_t n, unsigned s)
+{
+    const unsigned t = sizeof(digit_t) * CHAR_BIT - s;
+    digit_t out = a[n - 1] >> t;
+    for (size_t i = n - 1; i > 0; i--)
+    {
+        r[i] = (a[i] << s) | (a[i - 1] >> t);
+    }
+    r[0] = a[0] << s;
+    return out;
+}
+
+//r[0..n) = a[0..n) >> s with 0 < s < DIGIT_BIT, returns the bits shifted out of the bottom.
+//Runs upwards, so r may sit at or below a.
+static digit_t rshiftGeneric(digit_t *r, const digit_t *a, size_t n, unsigned s)
+{
+    const unsigned t = sizeof(digit_t) * CHAR_BIT - s;
+    digit_t out = a[0] << t;
+    for (size_t i = 0; i + 1 < n; i++)
+    {
+        r[i] = (a[i] >> s) | (a[i + 1] << t);
+    }
+    r[n - 1] = a[n - 1] >> s;
+    return out;
+}
+
+#ifdef BIGINT_CARRY_INTRINSICS
+//funnel shifts four digits at a time. Every load of a block happens before its store and later
+//blocks only read digits below (lshift) or above (rshift) it, so the overlap rules of the
+//portable loops still hold.
+__attribute__((target("avx2"))) static digit_t lshiftAvx2(digit_t *r, const digit_t *a, size_t n, unsigned s)
+{
+    const unsigned t = 64 - s;
+    const __m128i vs = _mm_cvtsi32_si128(s);
+    const __m128i vt = _mm_cvtsi32_si128(t);
+    digit_t out = a[n - 1] >> t;
+    size_t i = n - 1;
+    for (; i >= 4; i -= 4)
+    {
+        __m256i hi = _mm256_loadu_si256((const __m256i *)(a + i - 3));
+        __m256i lo = _mm256_loadu_si256((const __m256i *)(a + i - 4));
+        _mm256_storeu_si256((__m256i *)(r + i - 3), _mm256_or_si256(_mm256_sll_epi64(hi, vs), _mm256_srl_epi64(lo, vt)));
+    }
+    for (; i > 0; i--)
+    {
+        r[i] = (a[i] << s) | (a[i - 1] >> t);
+    }
+    r[0] = a[0] << s;
+    return out;
+}
+
+__attribute__((target("avx2"))) static digit_t rshiftAvx2(digit_t *r, const digit_t *a, size_t n, unsigned s)
+{
+    const unsigned t = 64 - s;
+    const __m128i vs = _mm_cvtsi32_si128(s);
+    const __m128i vt = _mm_cvtsi32_si128(t);
+    digit_t out = a[0] << t;
+    size_t i = 0;
+    for (; i + 4 < n; i += 4)
+    {
+        __m256i lo = _mm256_loadu_si256((const __m256i *)(a + i));
+        __m256i hi = _mm256_loadu_si256((const __m256i *)(a + i + 1));
+        _mm256_storeu_si256((__m256i *)(r + i), _mm256_or_si256(_mm256_srl_epi64(lo, vs), _mm256_sll_epi64(hi, vt)));
+    }
+    for (; i + 1 < n; i++)
+    {
+        r[i] = (a[i] >> s) | (a[i + 1] << t);
+    }
+    r[n - 1] = a[n - 1] >> s;
+    return out;
+}
+
+__attribute__((target("adx,bmi2"))) static digit_t addNAdx(digit_t *r, const digit_t *a, const digit_t *b, size_t n)
+{
+    unsigned char c = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        unsigned long long t;
+        c = _addcarryx_u64(c, a[i], b[i], &t);
+        r[i] = t;
+    }
+    return c;
+}
+
+__attribute__((target("adx,bmi2"))) static digit_t subNAdx(digit_t *r, const digit_t *a, const digit_t *b, size_t n)
+{
+    unsigned char c = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        unsigned long long t;
+        c = _subborrow_u64(c, a[i], b[i], &t);
+        r[i] = t;
+    }
+    return c;
+}
+
+//two independent carry chains, adcx folds the previous high half into the product and adox
+//accumulates it into r. rcx counts up from -n so that jrcxz closes the loop without touching flags.
+__attribute__((target("adx,bmi2"))) static digit_t addMul1Adx(digit_t *r, const digit_t *a, size_t n, digit_t b)
+{
+    if (n == 0)
+    {
+        return 0;
+    }
+    digit_t carry = 0, lo, hi;
+    long i = -(long)n;
+    __asm__ volatile(
+        "xor %%eax, %%eax\n\t"
+        "1:\n\t"
+        "mulx (%[a],%[i],8), %[lo], %[hi]\n\t"
+        "adcx %[carry], %[lo]\n\t"
+        "adox (%[r],%[i],8), %[lo]\n\t"
+        "mov %[lo], (%[r],%[i],8)\n\t"
+        "mov %[hi], %[carry]\n\t"
+        "lea 1(%[i]), %[i]\n\t"
+        "jrcxz 2f\n\t"
+        "jmp 1b\n\t"
+        "2:\n\t"
+        "mov $0, %%eax\n\t"
+        "adcx %%rax, %[carry]\n\t"
+        "adox %%rax, %[carry]\n\t"
+        : [carry] "+&r"(carry), [lo] "=&r"(lo), [hi] "=&r"(hi), [i] "+c"(i)
+        : [a] "r"(a + n), [r] "r"(r + n), "d"(b)
+        : "rax", "cc", "memory");
+    return carry;
+}
+
+//as addMul1Adx, but adds the complement of the product into r with the adox chain primed to one,
+//so that r - p = r + ~p + 1. The borrow out is the high digit plus the inverted final OF.
+__attribute__((target("adx,bmi2"))) static digit_t subMul1Adx(digit_t *r, const digit_t *a, size_t n, digit_t b)
+{
+    if (n == 0)
+    {
+        return 0;
+    }
+    digit_t borrow = 0, lo, hi, of;
+    long i = -(long)n;
+    __asm__ volatile(
+        "mov $0x7fffffffffffffff, %%rax\n\t"
+        "add $1, %%rax\n\t"
+        "1:\n\t"
+        "mulx (%[a],%[i],8), %[lo], %[hi]\n\t"
+        "adcx %[borrow], %[lo]\n\t"
+        "not %[lo]\n\t"
+        "adox (%[r],%[i],8), %[lo]\n\t"
+        "mov %[lo], (%[r],%[i],8)\n\t"
+        "mov %[hi], %[borrow]\n\t"
+        "lea 1(%[i]), %[i]\n\t"
+        "jrcxz 2f\n\t"
+        "jmp 1b\n\t"
+        "2:\n\t"
+        "mov $0, %%eax\n\t"
+        "adcx %%rax, %[borrow]\n\t"
+        "seto %%al\n\t"
+        "mov %%rax, %[of]\n\t"
+        : [borrow] "+&r"(borrow), [lo] "=&r"(lo), [hi] "=&r"(hi), [i] "+c"(i), [of] "=&r"(of)
+        : [a] "r"(a + n), [r] "r"(r + n), "d"(b)
+        : "rax", "cc", "memory");
+    return borrow + 1 - of;
+}
+#endif
+
+struct Kernels
+{
+    digit_t (*addN)(digit_t *r, const digit_t *a, const digit_t *b, size_t n);
+    digit_t (*subN)(digit_t *r, const digit_t *a, const digit_t *b, size_t n);
+    digit_t (*mul1)(digit_t *r, const digit_t *a, size_t n, digit_t b);
+    digit_t (*addMul1)(digit_t *r, const digit_t *a, size_t n, digit_t b);
+    digit_t (*subMul1)(digit_t *r, const digit_t *a, size_t n, digit_t b);
+    digit_t (*lshift)(digit_t *r, const digit_t *a, size_t n, unsigned s);
+    digit_t (*rshift)(digit_t *r, const digit_t *a, size_t n, unsigned s);
+};
+
+static Kernels selectKernels()
+{
+    Kernels k = {addNGeneric, subNGeneric, mul1Generic, addMul1Generic, subMul1Generic, lshiftGeneric, rshiftGeneric};
+#ifdef BIGINT_CARRY_INTRINSICS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("adx") && __builtin_cpu_supports("bmi2"))
+    {
+        k.addN = addNAdx;
+        k.subN = subNAdx;
+        k.addMul1 = addMul1Adx;
+        k.subMul1 = subMul1Adx;
+    }
+    if (__builtin_cpu_supports("avx2"))
+    {
+        k.lshift = lshiftAvx2;
+        k.rshift = rshiftAvx2;
+    }
+#endif
+    return k;
+}
+
+static inline const Kernels &kernels()
+{
+    static const Kernels k = selectKernels();
+    return k;
+}
+
+static inline digit_t addN(digit_t *r, const digit_t *a, const digit_t *b, size_t n)
+{
+    return kernels().addN(r, a, b, n);
+}
+
+static inline digit_t subN(digit_t *r, const digit_t *a, const digit_t *b, size_t n)
+{
+    return kernels().subN(r, a, b, n);
+}
+
+static inline digit_t mul1(digit_t *r, const digit_t *a, size_t n, digit_t b)
+{
+    return kernels().mul1(r, a, n, b);
+}
+
+static inline digit_t addMul1(digit_t *r, const digit_t *a, size_t n, digit_t b)
+{
+    return kernels().addMul1(r, a, n, b);
+}
+
+static inline digit_t subMul1(digit_t *r, const digit_t *a, size_t n, digit_t b)
+{
+    return kernels().subMul1(r, a, n, b);
+}
+
+static inline digit_t lshift(digit_t *r, const digit_t *a, size_t n, unsigned s)
+{
+    return kernels().lshift(r, a, n, s);
+}
+
+static inline digit_t rshift(digit_t *r, const digit_t *a, size_t n, unsigned s)
+{
+    return kernels().rshift(r, a, n, s);
+}
+
+//r += c over n digits, returns the carry out of r
+static inline digit_t add1(digit_t *r, size_t n, digit_t c)
+{
+    for (size_t i = 0; i < n && c; i++)
+    {
+        r[i] += c;
+        c = r[i] < c;
+    }
+    return c;
+}
+
+//r -= b over n digits, returns the borrow out of r
+static inline digit_t sub1(digit_t *r, size_t n, digit_t b)
+{
+    for (size_t i = 0; i < n && b; i++)
+    {
+        digit_t x = r[i];
+        r[i] = x - b;
+        b = x < b;
+    }
+    return b;
+}
+
+//r = B^n - r, the magnitude of a value that went below zero
+static inline void negate(digit_t *r, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        r[i] = ~r[i];
+    }
+    add1(r, n, 1);
+}
+
+//r[0..rn) += a[0..an) with an <= rn, returns the carry out of r
+static inline digit_t addTo(digit_t *r, size_t rn, const digit_t *a, size_t an)
+{
+    return add1(r + an, rn - an, addN(r, r, a, an));
+}
+
+//r[0..rn) -= a[0..an) with an <= rn, returns the borrow out of r
+static inline digit_t subFrom(digit_t *r, size_t rn, const digit_t *a, size_t an)
+{
+    return sub1(r + an, rn - an, subN(r, r, a, an));
+}
+
+BigInt &BigInt::addAbs(const BigInt &o)
+{
+    size_t n = this->numeral.size();
+    size_t m = o.numeral.size();
+
+    digit_t c; //carry
+    if (n >= m)
+    {
+        c = addTo(this->numeral.data(), n, o.numeral.data(), m);
+    }
+    else
+    {
+        this->numeral.resize(m);
+        digit_t *r = this->numeral.data();
+        c = addN(r, r, o.numeral.data(), n);
+        std::copy(o.numeral.begin() + n, o.numeral.end(), r + n);
+        c = add1(r + n, m - n, c);
+    }
+
+    if (c != 0)
+    {
+        this->numeral.push_back(c);
+    }
+
+    return *this;
+}
+
+BigInt &BigInt::subAbs(const BigInt &o)
+{
+    int d = BigInt::cmpAbs(*this, o);
+    if (d == 0)
+    {
+        this->numeral.clear();
+        this->sign = BigInt::SIGN_POS;
+        return *this;
+    }
+
+    if (d > 0)
+    {
+        subFrom(this->numeral.data(), this->numeral.size(), o.numeral.data(), o.numeral.size());
+    }
+    else
+    {
+        //|this| < |o|, subtract the other way round in place
+        size_t n = this->numeral.size(); //min
+        size_t m = o.numeral.size();     //max
+
+        this->numeral.resize(m);
+        digit_t *r = this->numeral.data();
+        digit_t b = subN(r, o.numeral.data(), r, n);
+        std::copy(o.numeral.begin() + n, o.numeral.end(), r + n);
+        sub1(r + n, m - n, b);
+        this->sign = -this->sign;
+    }
+
+    this->trim();
+
+    return *this;
+}
+
+BigInt &BigInt::addAbs(uddigit_t o)
+{
+    //o is consumed a digit at a time, the carry folds into what is left of it
+    size_t length = this->numeral.size();
+    for (size_t i = 0; i < length && o != 0; i++)
+    {
+        uddigit_t sum = (uddigit_t)this->numeral[i] + (o & BigInt::DIGIT_MAX);
+        this->numeral[i] = sum & BigInt::DIGIT_MAX;
+        o = (o >> BigInt::DIGIT_BIT) + (sum >> BigInt::DIGIT_BIT);
+    }
+    while (o != 0)
+    {
+        this->numeral.push_back(o & BigInt::DIGIT_MAX);
+        o >>= BigInt::DIGIT_BIT;
+    }
+    return *this;
+}
+
+BigInt &BigInt::subAbs(uddigit_t o)
+{
+    int d = BigInt::cmpAbs(*this, o);
+    if (d == 0)
+    {
+        this->numeral.clear();
+        this->sign = BigInt::SIGN_POS;
+        return *this;
+    }
+
+    if (d < 0)
+    {
+        //|this| < o, so |this| fits in a double digit
+        uddigit_t v = 0;
+        size_t length = this->numeral.size();
+        for (size_t i = length - 1; i < length; i--)
+        {
+            v = (v << BigInt::DIGIT_BIT) | this->numeral[i];
+        }
+        v = o - v;
+        this->numeral.clear();
+        while (v != 0)
+        {
+            this->numeral.push_back(v & BigInt::DIGIT_MAX);
+            v >>= BigInt::DIGIT_BIT;
+        }
+        this->sign = -this->sign;
+        return *this;
+    }
+
+    //o is consumed a digit at a time, the borrow folds into what is left of it
+    for (size_t i = 0; o != 0; i++)
+    {
+        digit_t s = o & BigInt::DIGIT_MAX;
+        o = (o >> BigInt::DIGIT_BIT) + (this->numeral[i] < s);
+        this->numeral[i] -= s;
+    }
+
+    this->trim();
+
+    return *this;
+}
+
+BigInt &BigInt::mulAbs(uddigit_t o)
+{
+    size_t length = this->numeral.size();
+    if (o == 0 || length == 0)
+    {
+        this->numeral.clear();
+        this->sign = BigInt::SIGN_POS;
+        return *this;
+    }
+
+    digit_t lo = o & BigInt::DIGIT_MAX;
+    digit_t hi = o >> BigInt::DIGIT_BIT;
+    uddigit_t carry = 0;
+
+    if (hi == 0)
+    {
+        digit_t c = mul1(this->numeral.data(), this->numeral.data(), length, lo);
+        if (c != 0)
+        {
+            this->numeral.push_back(c);
+        }
+        return *this;
+    }
+
+    //two digit multiplier: digit i of the product collects numeral[i] * lo + numeral[i - 1] * hi,
+    //the original numeral[i - 1] is kept in prev since it has already been overwritten
+    digit_t prev = 0;
+    for (size_t i = 0; i < length; i++)
+    {
+        digit_t cur = this->numeral[i];
+        uddigit_t t1 = (uddigit_t)cur * lo + (carry & BigInt::DIGIT_MAX);
+        uddigit_t t2 = (uddigit_t)prev * hi + (t1 & BigInt::DIGIT_MAX);
+        this->numeral[i] = t2 & BigInt::DIGIT_MAX;
+        carry = (carry >> BigInt::DIGIT_BIT) + (t1 >> BigInt::DIGIT_BIT) + (t2 >> BigInt::DIGIT_BIT);
+        prev = cur;
+    }
+    carry += (uddigit_t)prev * hi;
+    this->numeral.push_back(carry & BigInt::DIGIT_MAX);
+    this->numeral.push_back(carry >> BigInt::DIGIT_BIT);
+
+    this->trim();
+
+    return *this;
+}
+
+BigInt &BigInt::operator+=(const ddigit_t o)
+{
+    int sign = o >= 0 ? BigInt::SIGN_POS : BigInt::SIGN_NEG;
+    if (this->sign != sign)
+    {
+        return this->subAbs(magnitude(o));
+    }
+    return this->addAbs(magnitude(o));
+}
+
+BigInt &BigInt::operator-=(const ddigit_t o)
+{
+    int sign = o >= 0 ? BigInt::SIGN_POS : BigInt::SIGN_NEG;
+    if (this->sign != sign)
+    {
+        return this->addAbs(magnitude(o));
+    }
+    return this->subAbs(magnitude(o));
+}
+
+BigInt &BigInt::operator*=(const ddigit_t o)
+{
+    this->mulAbs(magnitude(o));
+    if (o < 0 && this->numeral.size() != 0)
+    {
+        this->sign = -this->sign;
+    }
+    return *this;
+}
+
+BigInt &BigInt::operator+=(const BigInt &o)
+{
+    if (this->sign != o.sign)
+    {
+        return this->subAbs(o);
+    }
+    return this->addAbs(o);
+}
+
+BigInt &BigInt::operator-=(const BigInt &o)
+{
+    if (this->sign != o.sign)
+    {
+        return this->addAbs(o);
+    }
+    return this->subAbs(o);
+}
+
+//r = |x - y| over xn digits with yn <= xn, returns true when y > x
+static bool absDiff(digit_t *r, const digit_t *x, size_t xn, const digit_t *y, size_t yn)
+{
+    bool neg = false;
+    size_t i = xn;
+    while (i > yn && x[i - 1] == 0)
+    {
+        i--;
+    }
+    if (i == yn)
+    {
+        while (i > 0 && x[i - 1] == y[i - 1])
+        {
+            i--;
+        }
+        neg = i > 0 && x[i - 1] < y[i - 1];
+    }
+
+    if (neg)
+    {
+        subN(r, y, x, yn);
+        std::fill(r + yn, r + xn, 0);
+    }
+    else
+    {
+        std::copy(x, x + xn, r);
+        subFrom(r, xn, y, yn);
+    }
+    return neg;
+}
+
+//r[0..n+m) = a[0..n) * b[0..m)
+static void mulBasecase(digit_t *r, const digit_t *a, size_t n, const digit_t *b, size_t m)
+{
+    r[m] = mul1(r, b, m, a[0]);
+    for (size_t i = 1; i < n; i++)
+    {
+        r[i + m] = addMul1(r + i, b, m, a[i]);
+    }
+}
+
+//r[0..2n) = a[0..n)^2, each cross product a[i] * a[j] with i < j is computed once and doubled
+static void sqrBasecase(digit_t *r, const digit_t *a, size_t n)
+{
+    const size_t bits = sizeof(digit_t) * CHAR_BIT;
+
+    std::fill(r, r + 2 * n, 0);
+    for (size_t i = 0; i + 1 < n; i++)
+    {
+        r[i + n] = addMul1(r + 2 * i + 1, a + i + 1, n - i - 1, a[i]);
+    }
+
+    //double the cross products and add the squares on the diagonal
+    digit_t top = 0;
+    uddigit_t carry = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        uddigit_t d = (uddigit_t)a[i] * a[i];
+        digit_t lo = r[2 * i];
+        digit_t hi = r[2 * i + 1];
+
+        uddigit_t sum = (uddigit_t)((lo << 1) | top) + (digit_t)d + carry;
+        r[2 * i] = (digit_t)sum;
+        sum = (uddigit_t)((hi << 1) | (lo >> (bits - 1))) + (d >> bits) + (sum >> bits);
+        r[2 * i + 1] = (digit_t)sum;
+        carry = sum >> bits;
+        top = hi >> (bits - 1);
+    }
+}
+
+//scratch digits needed by karatsuba and karatsubaSquare for a longest operand of n digits
+static size_t karatsubaScratch(size_t n, size_t threshold)
+{
+    size_t s = 0;
+    while (n >= threshold)
+    {
+        n = (n + 1) / 2;
+        s += 6 * n + 2;
+    }
+    return s;
+}
+
+//r[0..n+m) = a[0..n) * b[0..m) with n >= m >= 1, every temporary lives in scratch
+static void karatsuba(digit_t *r, const digit_t *a, size_t n, const digit_t *b, size_t m, digit_t *scratch, size_t threshold)
+{
+    if (m < threshold)
+    {
+        mulBasecase(r, a, n, b, m);
+        return;
+    }
+
+    size_t k = (n + 1) / 2;
+    if (m <= k)
+    {
+        //unbalanced, a0 * b + a1 * b * B^k
+        digit_t *t = scratch;
+        karatsuba(r, a, k, b, m, scratch, threshold);
+        std::fill(r + k + m, r + n + m, 0);
+        if (n - k >= m)
+        {
+            karatsuba(t, a + k, n - k, b, m, scratch + (n - k + m), threshold);
+        }
+        else
+        {
+            karatsuba(t, b, m, a + k, n - k, scratch + (n - k + m), threshold);
+        }
+        addTo(r + k, n + m - k, t, n - k + m);
+        return;
+    }
+
+    //c = a1 * b1 * B^2k + (a0 * b0 + a1 * b1 - (a0 - a1) * (b0 - b1)) * B^k + a0 * b0
+    digit_t *da = scratch;
+    digit_t *db = da + k;
+    digit_t *t = db + k;
+    digit_t *mid = t + 2 * k;
+    digit_t *next = mid + 2 * k + 1;
+
+    bool neg = absDiff(da, a, k, a + k, n - k) != absDiff(db, b, k, b + k, m - k);
+
+    karatsuba(r, a, k, b, k, next, threshold);
+    karatsuba(r + 2 * k, a + k, n - k, b + k, m - k, next, threshold);
+    karatsuba(t, da, k, db, k, next, threshold);
+
+    std::copy(r, r + 2 * k, mid);
+    mid[2 * k] = addTo(mid, 2 * k, r + 2 * k, n + m - 2 * k);
+    if (neg)
+    {
+        addTo(mid, 2 * k + 1, t, 2 * k);
+    }
+    else
+    {
+        subFrom(mid, 2 * k + 1, t, 2 * k);
+    }
+    addTo(r + k, n + m - k, mid, std::min(2 * k + 1, n + m - k));
+}
+
+//r[0..2n) = a[0..n)^2 from three half size squarings
+static void karatsubaSquare(digit_t *r, const digit_t *a, size_t n, digit_t *scratch, size_t threshold)
+{
+    if (n < threshold)
+    {
+        sqrBasecase(r, a, n);
+        return;
+    }
+
+    //x^2 = x1^2 * B^2k + (x0^2 + x1^2 - (x0 - x1)^2) * B^k + x0^2
+    size_t k = (n + 1) / 2;
+    digit_t *d = scratch;
+    digit_t *t = d + k;
+    digit_t *mid = t + 2 * k;
+    digit_t *next = mid + 2 * k + 1;
+
+    absDiff(d, a, k, a + k, n - k);
+
+    karatsubaSquare(r, a, k, next, threshold);
+    karatsubaSquare(r + 2 * k, a + k, n - k, next, threshold);
+    karatsubaSquare(t, d, k, next, threshold);
+
+    std::copy(r, r + 2 * k, mid);
+    mid[2 * k] = addTo(mid, 2 * k, r + 2 * k, 2 * n - 2 * k);
+    subFrom(mid, 2 * k + 1, t, 2 * k);
+    addTo(r + k, 2 * n - k, mid, std::min(2 * k + 1, 2 * n - k));
+}
+
+BigInt BigInt::baseMul(const BigInt &l, const BigInt &r)
+{
+    size_t lsize = l.numeral.size();
+    size_t rsize = r.numeral.size();
+    if (lsize == 0 || rsize == 0)
+    {
+        return 0;
+    }
+
+    BigInt mul;
+    mul.numeral.resize(lsize + rsize);
+    mulBasecase(mul.numeral.data(), l.numeral.data(), lsize, r.numeral.data(), rsize);
+    mul.trim();
+    mul.sign = l.sign * r.sign;
+    return mul;
+}
+
+BigInt BigInt::baseSqr(const BigInt &l)
+{
+    size_t n = l.numeral.size();
+
+    BigInt sqr;
+    sqr.numeral.resize(2 * n);
+    sqrBasecase(sqr.numeral.data(), l.numeral.data(), n);
+    sqr.trim();
+    return sqr;
+}
+
+BigInt BigInt::karatsubaMul(const BigInt &l, const BigInt &r)
+{
+    const BigInt &a = l.numeral.size() >= r.numeral.size() ? l : r;
+    const BigInt &b = l.numeral.size() >= r.numeral.size() ? r : l;
+    size_t n = a.numeral.size();
+    size_t m = b.numeral.size();
+
+    if (m == 0)
+    {
+        return 0;
+    }
+
+    //one scratch buffer for the whole recursion, the operands are only read
+    std::vector<digit_t> scratch(karatsubaScratch(n, BigInt::KARATSUBA_THRESHOLD));
+
+    BigInt c;
+    c.numeral.resize(n + m);
+    karatsuba(c.numeral.data(), a.numeral.data(), n, b.numeral.data(), m, scratch.data(), BigInt::KARATSUBA_THRESHOLD);
+    c.trim();
+    c.sign = l.sign * r.sign;
+    return c;
+}
+
+BigInt BigInt::karatsubaSqr(const BigInt &l)
+{
+    size_t n = l.numeral.size();
+    std::vector<digit_t> scratch(karatsubaScratch(n, BigInt::KARATSUBA_SQR_THRESHOLD));
+
+    BigInt c;
+    c.numeral.resize(2 * n);
+    karatsubaSquare(c.numeral.data(), l.numeral.data(), n, scratch.data(), BigInt::KARATSUBA_SQR_THRESHOLD);
+    c.trim();
+    return c;
+}
+
+//this += sign * |l| * |r|. Basecase rows go through addMul1 straight into the digits of this,
+//Karatsuba sizes build the product in a per thread buffer and take one pass over this.
+BigInt &BigInt::mulAcc(const BigInt &l, const BigInt &r, int sign)
+{
+    const BigInt &a = l.numeral.size() >= r.numeral.size() ? l : r;
+    const BigInt &b = l.numeral.size() >= r.numeral.size() ? r : l;
+    size_t n = a.numeral.size();
+    size_t m = b.numeral.size();
+
+    if (m == 0)
+    {
+        return *this;
+    }
+    if (&l == this || &r == this || m >= BigInt::TOOM3_THRESHOLD || (m >= BigInt::KARATSUBA_THRESHOLD && n >= 2 * m))
+    {
+        //the operands would be overwritten, or the product is built whole by the larger algorithms anyway
+        BigInt p = BigInt::mul(l, r);
+        p.sign = sign;
+        return *this += p;
+    }
+
+    if (this->numeral.size() == 0)
+    {
+        this->sign = sign;
+    }
+    bool add = this->sign == sign;
+
+    size_t length = std::max(this->numeral.size(), n + m);
+    this->numeral.resize(length);
+    digit_t *d = this->numeral.data();
+    const digit_t *x = a.numeral.data();
+    const digit_t *y = b.numeral.data();
+
+    //a difference is taken as B^length - (B^length - |this| + |l * r|) so that the product is only
+    //ever added, the sum then carries out exactly when the product is at least |this|
+    if (!add)
+    {
+        negate(d, length);
+    }
+
+    digit_t carry = 0;
+    if (m < BigInt::KARATSUBA_THRESHOLD)
+    {
+        for (size_t i = 0; i < m; i++)
+        {
+            carry |= add1(d + i + n, length - i - n, addMul1(d + i, x, n, y[i]));
+        }
+    }
+    else
+    {
+        static thread_local std::vector<digit_t> work;
+        work.resize(n + m + karatsubaScratch(n, BigInt::KARATSUBA_THRESHOLD));
+        karatsuba(work.data(), x, n, y, m, work.data() + n + m, BigInt::KARATSUBA_THRESHOLD);
+        carry = addTo(d, length, work.data(), n + m);
+    }
+
+    if (add)
+    {
+        if (carry != 0)
+        {
+            this->numeral.push_back(carry);
+        }
+    }
+    else if (carry != 0)
+    {
+        this->sign = -this->sign;
+    }
+    else
+    {
+        negate(d, length);
+    }
+    this->trim();
+    if (this->numeral.size() == 0)
+    {
+        this->sign = BigInt::SIGN_POS;
+    }
+    return *this;
+}
+
+//this += sign * |l| * r, l may be this object
+BigInt &BigInt::mulAcc(const BigInt &l, digit_t r, int sign)
+{
+    size_t n = l.numeral.size();
+    if (n == 0 || r == 0)
+    {
+        return *this;
+    }
+
+    if (this->numeral.size() == 0)
+    {
+        this->sign = sign;
+    }
+    bool add = this->sign == sign;
+
+    size_t length = std::max(this->numeral.size(), n + 1);
+    this->numeral.resize(length);
+    digit_t *d = this->numeral.data();
+    const digit_t *x = l.numeral.data();
+
+    if (add)
+    {
+        digit_t carry = add1(d + n, length - n, addMul1(d, x, n, r));
+        if (carry != 0)
+        {
+            this->numeral.push_back(carry);
+        }
+    }
+    else if (sub1(d + n, length - n, subMul1(d, x, n, r)) != 0)
+    {
+        //went below zero, take the two's complement
+        negate(d, length);
+        this->sign = -this->sign;
+    }
+    this->trim();
+    if (this->numeral.size() == 0)
+    {
+        this->sign = BigInt::SIGN_POS;
+    }
+    return *this;
+}
+
+BigInt &BigInt::addmul(const BigInt &l, const BigInt &r)
+{
+    return this->mulAcc(l, r, l.sign * r.sign);
+}
+
+BigInt &BigInt::submul(const BigInt &l, const BigInt &r)
+{
+    return this->mulAcc(l, r, -l.sign * r.sign);
+}
+
+BigInt &BigInt::addmul(const BigInt &l, ddigit_t r)
+{
+    uddigit_t m = magnitude(r);
+    if (m > BigInt::DIGIT_MAX)
+    {
+        return this->addmul(l, BigInt(r));
+    }
+    return this->mulAcc(l, (digit_t)m, r < 0 ? -l.sign : l.sign);
+}
+
+BigInt &BigInt::submul(const BigInt &l, ddigit_t r)
+{
+    uddigit_t m = magnitude(r);
+    if (m > BigInt::DIGIT_MAX)
+    {
+        return this->submul(l, BigInt(r));
+    }
+    return this->mulAcc(l, (digit_t)m, r < 0 ? l.sign : -l.sign);
+}
+
+//one term of a lazy sum, digit i of the term comes from d[i + offset] and its neighbour
+struct LazyDigits
+{
+    const digit_t *d;
+    size_t n;
+    ptrdiff_t offset;
+    unsigned bits; //remaining shift within a digit, to the left when left is set
+    bool left;
+    bool neg;
+    size_t lo, hi; //the digits that can be non-zero
+    digit_t carry; //into the next block
+
+    //digits [i, i + len) of the term within [lo, hi), in place when unshifted, otherwise through the
+    //shift kernels into buf of len + 2 digits
+    const digit_t *digits(size_t i, size_t len, digit_t *buf) const
+    {
+        size_t j = i + this->offset;
+        if (this->bits == 0)
+        {
+            return this->d + j;
+        }
+        if (!this->left)
+        {
+            rshift(buf, this->d + j, std::min(len + 1, this->n - j), this->bits);
+            return buf;
+        }
+
+        //the top digit of a left shift is what the kernel shifts out
+        size_t m = j + len > this->n ? len - 1 : len;
+        if (j == 0)
+        {
+            buf[m] = lshift(buf, this->d, m, this->bits);
+            return buf;
+        }
+        buf[m + 1] = lshift(buf, this->d + j - 1, m + 1, this->bits);
+        return buf + 1;
+    }
+};
+
+void BigInt::evaluate(BigInt &r, const LazyTerm *t, size_t k)
+{
+    //the result is written while the terms are read, so it cannot be one of them
+    for (size_t i = 0; i < k; i++)
+    {
+        if (t[i].v == &r || t[i].w == &r)
+        {
+            BigInt tmp;
+            BigInt::evaluate(tmp, t, k);
+            r = std::move(tmp);
+            return;
+        }
+    }
+
+    SmallVector<LazyDigits, 8> sums;
+    size_t length = 0;
+    for (size_t i = 0; i < k; i++)
+    {
+        size_t n = t[i].v->numeral.size();
+        if (t[i].w != nullptr)
+        {
+            //products are accumulated afterwards, into the storage sized here
+            length = std::max(length, n + t[i].w->numeral.size());
+            continue;
+        }
+        if (n == 0)
+        {
+            continue;
+        }
+
+        size_t bits = t[i].shift >= 0 ? t[i].shift : -t[i].shift;
+        size_t q = bits / BigInt::DIGIT_BIT;
+        LazyDigits s;
+        s.d = t[i].v->numeral.data();
+        s.n = n;
+        s.bits = bits % BigInt::DIGIT_BIT;
+        s.left = t[i].shift >= 0;
+        s.offset = s.left ? -(ptrdiff_t)q : (ptrdiff_t)q;
+        s.neg = t[i].sign * t[i].v->sign < 0;
+        s.lo = s.left ? q : 0;
+        s.hi = s.left ? n + q + (s.bits != 0) : n - std::min(n, q);
+        s.carry = 0;
+        if (s.lo < s.hi)
+        {
+            sums.push_back(s);
+            length = std::max(length, s.hi);
+        }
+    }
+
+    //the first term is copied rather than added, so it has to be a positive one. Without any, the
+    //negated sum is computed instead.
+    int sign = BigInt::SIGN_POS;
+    size_t first = 0;
+    while (first < sums.size() && sums[first].neg)
+    {
+        first++;
+    }
+    if (first == sums.size())
+    {
+        for (size_t j = 0; j < sums.size(); j++)
+        {
+            sums[j].neg = false;
+        }
+        sign = BigInt::SIGN_NEG;
+        first = 0;
+    }
+    if (first != 0)
+    {
+        std::swap(sums[0], sums[first]);
+    }
+
+    //one spare digit takes the carries of the sum, which stay below the number of terms
+    r.numeral.clear();
+    length = sums.size() != 0 ? length + 1 : 0;
+    r.numeral.resize_uninitialized(length);
+    digit_t *d = r.numeral.data();
+
+    //block by block so that the result stays in cache while every term is added to or subtracted
+    //from it, the carries and borrows of each term move on to the next block
+    const size_t block = 256;
+    digit_t buf[block + 2];
+    for (size_t i = 0; i < length; i += block)
+    {
+        size_t end = std::min(i + block, length);
+        for (size_t j = 0; j < sums.size(); j++)
+        {
+            LazyDigits &s = sums[j];
+            size_t lo = std::max(i, s.lo);
+            size_t hi = std::min(end, s.hi);
+            if (j == 0)
+            {
+                //the digits of the block are not initialized yet
+                lo = std::min(lo, end);
+                hi = std::max(lo, hi);
+                std::fill(d + i, d + lo, 0);
+                if (lo < hi)
+                {
+                    const digit_t *x = s.digits(lo, hi - lo, buf);
+                    std::copy(x, x + (hi - lo), d + lo);
+                }
+                std::fill(d + hi, d + end, 0);
+                continue;
+            }
+            digit_t c = s.neg ? sub1(d + i, end - i, s.carry) : add1(d + i, end - i, s.carry);
+            if (lo < hi)
+            {
+                const digit_t *x = s.digits(lo, hi - lo, buf);
+                c += s.neg ? subFrom(d + lo, end - lo, x, hi - lo) : addTo(d + lo, end - lo, x, hi - lo);
+            }
+            s.carry = c;
+        }
+    }
+
+    //the sum wrapped around when more borrows than carries are left over
+    size_t carries = 0;
+    size_t borrows = 0;
+    for (size_t j = 0; j < sums.size(); j++)
+    {
+        (sums[j].neg ? borrows : carries) += sums[j].carry;
+    }
+    r.sign = sign;
+    if (borrows > carries)
+    {
+        negate(d, length);
+        r.sign = -sign;
+    }
+    r.trim();
+
+    for (size_t i = 0; i < k; i++)
+    {
+        if (t[i].w == nullptr)
+        {
+            continue;
+        }
+        if (r.numeral.size() == 0)
+        {
+            r = BigInt::mul(*t[i].v, *t[i].w);
+            r.sign *= t[i].sign;
+        }
+        else if (t[i].sign > 0)
+        {
+            r.addmul(*t[i].v, *t[i].w);
+        }
+        else
+        {
+            r.submul(*t[i].v, *t[i].w);
+        }
+    }
+    if (r.numeral.size() == 0)
+    {
+        r.sign = BigInt::SIGN_POS;
+    }
+}
+
+BigInt &BigInt::addAbs(const BigInt &o, size_t offset)
+{
+    size_t m = o.numeral.size();
+    if (this->numeral.size() < offset + m)
+    {
+        this->numeral.resize(offset + m, 0);
+    }
+
+    size_t length = this->numeral.size();
+    digit_t c = addTo(this->numeral.data() + offset, length - offset, o.numeral.data(), m);
+    if (c != 0)
+    {
+        this->numeral.push_back(c);
+    }
+    return *this;
+}
+
+//fork-join pool for independent subproducts. The queue is shared and a thread waiting on its
+//group keeps taking queued tasks, so nested groups never block a worker.
+class TaskPool
+{
+public:
+    static TaskPool &instance()
+    {
+        static TaskPool pool;
+        return pool;
+    }
+
+    ~TaskPool()
+    {
+        this->resize(1);
+    }
+
+    //n threads in total including the caller. Resizes are serialized, and the old workers drain the
+    //queue before they exit, so multiplications running on other threads still complete.
+    void resize(size_t n)
+    {
+        std::lock_guard<std::mutex> guard(this->resizing);
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->stop = true;
+        }
+        this->cv.notify_all();
+        for (size_t i = 0; i < this->workers.size(); i++)
+        {
+            this->workers[i].join();
+        }
+        this->workers.clear();
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->stop = false;
+        }
+        for (size_t i = 1; i < n; i++)
+        {
+            this->workers.push_back(std::thread(&TaskPool::work, this));
+        }
+        this->count = n;
+    }
+
+    size_t size() const
+    {
+        return this->count;
+    }
+
+    //nesting depth of the task running on this thread, for the parallel cutoff
+    static size_t &depth()
+    {
+        static thread_local size_t d = 0;
+        return d;
+    }
+
+    //runs every task and returns when all of them are done, the caller runs the first one
+    void run(std::vector<std::function<void()>> &tasks)
+    {
+        size_t pending = tasks.size() - 1;
+        size_t d = TaskPool::depth() + 1;
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            for (size_t i = 1; i < tasks.size(); i++)
+            {
+                this->queue.push_back(Task{&tasks[i], &pending, d});
+            }
+        }
+        this->cv.notify_all();
+
+        TaskPool::execute(Task{&tasks[0], NULL, d});
+
+        std::unique_lock<std::mutex> lock(this->mutex);
+        while (pending != 0)
+        {
+            if (this->queue.empty())
+            {
+                this->cv.wait(lock);
+                continue;
+            }
+            Task t = this->queue.front();
+            this->queue.pop_front();
+            lock.unlock();
+            TaskPool::execute(t);
+            lock.lock();
+            this->finish(t);
+        }
+    }
+
+private:
+    struct Task
+    {
+        std::function<void()> *f;
+        size_t *pending;
+        size_t depth;
+    };
+
+    std::vector<std::thread> workers;
+    std::atomic<size_t> count{1};
+    std::mutex resizing;
+    std::deque<Task> queue;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool stop = false;
+
+    static void execute(const Task &t)
+    {
+        size_t saved = TaskPool::depth();
+        TaskPool::depth() = t.depth;
+        (*t.f)();
+        TaskPool::depth() = saved;
+    }
+
+    //called with the mutex held
+    void finish(const Task &t)
+    {
+        if (--*t.pending == 0)
+        {
+            this->cv.notify_all();
+        }
+    }
+
+    void work()
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        while (true)
+        {
+            if (this->queue.empty())
+            {
+                if (this->stop)
+                {
+                    return;
+                }
+                this->cv.wait(lock);
+                continue;
+            }
+            Task t = this->queue.front();
+            this->queue.pop_front();
+            lock.unlock();
+            TaskPool::execute(t);
+            lock.lock();
+            this->finish(t);
+        }
+    }
+};
+
+void BigInt::setThreads(size_t n)
+{
+    //a worker would have to join itself
+    if (TaskPool::depth() != 0)
+    {
+        throw std::logic_error("BigInt: setThreads called from a pool task");
+    }
+    TaskPool::instance().resize(std::max<size_t>(n, 1));
+}
+
+size_t BigInt::threads()
+{
+    return TaskPool::instance().size();
+}
+
+//forks when the pool has threads, the operands are large enough and the nesting is shallow enough
+bool BigInt::parallel(size_t n)
+{
+    TaskPool &pool = TaskPool::instance();
+    return pool.size() > 1 && n >= BigInt::PARALLEL_THRESHOLD && TaskPool::depth() < BigInt::PARALLEL_DEPTH;
+}
+
+static void runTasks(std::vector<std::function<void()>> &tasks, bool parallel)
+{
+    if (parallel)
+    {
+        TaskPool::instance().run(tasks);
+        return;
+    }
+    for (size_t i = 0; i < tasks.size(); i++)
+    {
+        tasks[i]();
+    }
+}
+
+//Toom-3, evaluation at 0, 1, -1, -2 and infinity with Bodrato's interpolation sequence
+BigInt BigInt::toom3Mul(const BigInt &l, const BigInt &r)
+{
+    size_t n = std::max(l.numeral.size(), r.numeral.size());
+    if (std::min(l.numeral.size(), r.numeral.size()) == 0)
+    {
+        return 0;
+    }
+
+    size_t k = (n + 2) / 3;
+    const bool square = &l == &r;
+
+    BigInt lp[5], rp[5];
+    const BigInt *parts[2] = {&l, &r};
+    BigInt *points[2] = {lp, rp};
+    for (size_t j = 0; j < (square ? 1u : 2u); j++)
+    {
+        BigInt a0 = BigInt::slice(*parts[j], 0, k);
+        BigInt a1 = BigInt::slice(*parts[j], k, 2 * k);
+        BigInt a2 = BigInt::slice(*parts[j], 2 * k, 3 * k);
+        BigInt *p = points[j];
+
+        BigInt even = a0 + a2;
+        p[1] = even + a1;
+        p[2] = std::move(even) - a1;
+        p[3] = ((p[2] + a2) << 1) - a0;
+
+        p[0] = std::move(a0);
+        p[4] = std::move(a2);
+    }
+
+    //pointwise products, a square passes the same point to both sides
+    BigInt w[5];
+    std::vector<std::function<void()>> tasks;
+    for (size_t i = 0; i < 5; i++)
+    {
+        tasks.push_back([&, i] { w[i] = BigInt::mul(lp[i], square ? lp[i] : rp[i]); });
+    }
+    runTasks(tasks, BigInt::parallel(k));
+    BigInt &w0 = w[0];
+    BigInt &w1 = w[1];
+    BigInt &wm1 = w[2];
+    BigInt &wm2 = w[3];
+    BigInt &winf = w[4];
+
+    //interpolation, all divisions are exact
+    BigInt c3 = wm2 - w1;
+    c3 /= 3;
+    BigInt c1 = w1 - wm1;
+    c1 /= 2;
+    BigInt c2 = wm1 - w0;
+    c3 = c2 - c3;
+    c3 /= 2;
+    c3 += winf << 1;
+    c2 += c1;
+    c2 -= winf;
+    c1 -= c3;
+
+    //recomposition, c = winf * x^4 + c3 * x^3 + c2 * x^2 + c1 * x + w0 with x = B^k. The coefficients
+    //of a product of non-negative parts are non-negative, so each one is added in at its digit offset.
+    BigInt c(std::move(w0));
+    c.numeral.reserve(l.numeral.size() + r.numeral.size() + 1);
+    c.addAbs(c1, k);
+    c.addAbs(c2, 2 * k);
+    c.addAbs(c3, 3 * k);
+    c.addAbs(winf, 4 * k);
+    c.trim();
+    c.sign = c.numeral.size() != 0 ? l.sign * r.sign : BigInt::SIGN_POS;
+    return c;
+}
+
+//Toom-4, evaluation at 0, 1, -1, 2, -2, 1/2 and infinity
+BigInt BigInt::toom4Mul(const BigInt &l, const BigInt &r)
+{
+    size_t n = std::max(l.numeral.size(), r.numeral.size());
+    if (std::min(l.numeral.size(), r.numeral.size()) == 0)
+    {
+        return 0;
+    }
+
+    size_t k = (n + 3) / 4;
+
+    const bool square = &l == &r;
+
+    BigInt lp[7], rp[7];
+    const BigInt *parts[2] = {&l, &r};
+    BigInt *points[2] = {lp, rp};
+    for (size_t j = 0; j < (square ? 1u : 2u); j++)
+    {
+        BigInt a0 = BigInt::slice(*parts[j], 0, k);
+        BigInt a1 = BigInt::slice(*parts[j], k, 2 * k);
+        BigInt a2 = BigInt::slice(*parts[j], 2 * k, 3 * k);
+        BigInt a3 = BigInt::slice(*parts[j], 3 * k, 4 * k);
+        BigInt *p = points[j];
+
+        BigInt even = a0 + a2;
+        BigInt odd = a1 + a3;
+        p[1] = even + odd;
+        p[2] = std::move(even) - odd;
+
+        even = a0 + (a2 << 2);
+        odd = (a1 << 1) + (a3 << 3);
+        p[3] = even + odd;
+        p[4] = std::move(even) - odd;
+
+        //8 * p(1/2)
+        p[5] = a0 << 1;
+        p[5] += a1;
+        p[5] <<= 1;
+        p[5] += a2;
+        p[5] <<= 1;
+        p[5] += a3;
+
+        p[0] = std::move(a0);
+        p[6] = std::move(a3);
+    }
+
+    //pointwise products, w[5] is 64 * r(1/2)
+    BigInt w[7];
+    std::vector<std::function<void()>> tasks;
+    for (size_t i = 0; i < 7; i++)
+    {
+        tasks.push_back([&, i] { w[i] = BigInt::mul(lp[i], square ? lp[i] : rp[i]); });
+    }
+    runTasks(tasks, BigInt::parallel(k));
+
+    //interpolation, all divisions are exact
+    BigInt &c0 = w[0];
+    BigInt &c6 = w[6];
+
+    BigInt e1 = w[1] + w[2];
+    e1 /= 2;
+    BigInt o1 = std::move(w[1]) - w[2];
+    o1 /= 2;
+    BigInt e2 = w[3] + w[4];
+    e2 /= 2;
+    BigInt o2 = std::move(w[3]) - w[4];
+    o2 /= 4;
+
+    //c2 + c4 and c2 + 4 * c4
+    e1 -= c0;
+    e1 -= c6;
+    e2 -= c0;
+    e2 -= c6 << 6;
+    e2 /= 4;
+    BigInt c4 = e2 - e1;
+    c4 /= 3;
+    BigInt c2 = std::move(e1) - c4;
+
+    //16 * c1 + 4 * c3 + c5
+    BigInt t = std::move(w[5]);
+    t -= c0 << 6;
+    t -= c2 << 4;
+    t -= c4 << 2;
+    t -= c6;
+    t /= 2;
+
+    //c3 + 5 * c5 and 5 * c1 + c3
+    BigInt u = std::move(o2) - o1;
+    u /= 3;
+    BigInt v = std::move(t) - o1;
+    v /= 3;
+    BigInt c3 = o1 * 5 - u - v;
+    c3 /= 3;
+    BigInt c5 = std::move(u) - c3;
+    c5 /= 5;
+    BigInt c1 = std::move(v) - c3;
+    c1 /= 5;
+
+    //recomposition with x = B^k, every coefficient is non-negative and added in at its digit offset
+    BigInt c(std::move(c0));
+    c.numeral.reserve(l.numeral.size() + r.numeral.size() + 1);
+    c.addAbs(c1, k);
+    c.addAbs(c2, 2 * k);
+    c.addAbs(c3, 3 * k);
+    c.addAbs(c4, 4 * k);
+    c.addAbs(c5, 5 * k);
+    c.addAbs(c6, 6 * k);
+    c.trim();
+    c.sign = c.numeral.size() != 0 ? l.sign * r.sign : BigInt::SIGN_POS;
+    return c;
+}
+
+//the transforms work on 32 bit words whatever the limb width, a limb is split into NTT_PIECES words
+static const size_t NTT_PIECES = sizeof(digit_t) / sizeof(uint32_t);
+
+//primes c * 2^k + 1 below 2^31 with a primitive root each, transforms up to 2^24 points
+static const uint32_t nttPrimes[3] = {2013265921, 469762049, 754974721};
+static const uint32_t nttRoots[3] = {31, 3, 11};
+
+static inline uint32_t powMod(uint64_t b, uint64_t e, uint32_t p)
+{
+    uint64_t r = 1;
+    b %= p;
+    while (e)
+    {
+        if (e & 1)
+        {
+            r = r * b % p;
+        }
+        b = b * b % p;
+        e >>= 1;
+    }
+    return (uint32_t)r;
+}
+
+//Montgomery reduction with R = 2^32, t < p * R and pinv = -p^-1 mod R
+static inline uint32_t montReduce(uint64_t t, uint32_t p, uint32_t pinv)
+{
+    uint32_t m = (uint32_t)t * pinv;
+    uint64_t u = (t + (uint64_t)m * p) >> 32;
+    return (uint32_t)(u >= p ? u - p : u);
+}
+
+//twiddles w_2len^j in Montgomery form at tw[len + j]
+static void nttTwiddles(std::vector<uint32_t> &tw, size_t n, uint32_t p, uint32_t g, bool inverse)
+{
+    tw.resize(n);
+    for (size_t len = 1; len < n; len <<= 1)
+    {
+        uint64_t w = powMod(g, (p - 1) / (2 * len), p);
+        if (inverse)
+        {
+            w = powMod(w, p - 2, p);
+        }
+        uint64_t x = ((uint64_t)1 << 32) % p;
+        for (size_t j = 0; j < len; j++)
+        {
+            tw[len + j] = (uint32_t)x;
+            x = x * w % p;
+        }
+    }
+}
+
+//decimation in frequency, natural order in and bit reversed order out
+static void nttForward(uint32_t *a, size_t n, const uint32_t *tw, uint32_t p, uint32_t pinv)
+{
+    for (size_t len = n / 2; len >= 1; len >>= 1)
+    {
+        for (size_t i = 0; i < n; i += 2 * len)
+        {
+            for (size_t j = 0; j < len; j++)
+            {
+                uint32_t u = a[i + j];
+                uint32_t v = a[i + j + len];
+                uint32_t s = u + v;
+                a[i + j] = s >= p ? s - p : s;
+                a[i + j + len] = montReduce((uint64_t)(u >= v ? u - v : u + p - v) * tw[len + j], p, pinv);
+            }
+        }
+    }
+}
+
+//decimation in time, bit reversed order in and natural order out
+static void nttInverse(uint32_t *a, size_t n, const uint32_t *tw, uint32_t p, uint32_t pinv)
+{
+    for (size_t len = 1; len < n; len <<= 1)
+    {
+        for (size_t i = 0; i < n; i += 2 * len)
+        {
+            for (size_t j = 0; j < len; j++)
+            {
+                uint32_t u = a[i + j];
+                uint32_t v = montReduce((uint64_t)a[i + j + len] * tw[len + j], p, pinv);
+                uint32_t s = u + v;
+                a[i + j] = s >= p ? s - p : s;
+                a[i + j + len] = u >= v ? u - v : u + p - v;
+            }
+        }
+    }
+}
+
+//three-prime number theoretic transform, the convolution is recovered exactly with the Chinese remainder theorem
+BigInt BigInt::nttMul(const BigInt &l, const BigInt &r)
+{
+    if (l.numeral.size() == 0 || r.numeral.size() == 0)
+    {
+        return 0;
+    }
+    //the primes have roots of unity up to 2^24 words, longer products take the Toom-Cook path of mul
+    if (l.numeral.size() + r.numeral.size() > BigInt::NTT_MAX_LENGTH)
+    {
+        return BigInt::mul(l, r);
+    }
+
+    //lengths in 32 bit words
+    size_t n = l.numeral.size() * NTT_PIECES;
+    size_t m = r.numeral.size() * NTT_PIECES;
+    size_t len = 1;
+    while (len < n + m)
+    {
+        len <<= 1;
+    }
+    assert(len <= ((size_t)1 << 24));
+
+    //a square transforms its operand once per prime
+    const bool square = &l == &r;
+    //the primes are independent, each one transforms into its own buffers
+    std::vector<uint32_t> res[3];
+    std::vector<std::function<void()>> tasks;
+    for (size_t k = 0; k < 3; k++)
+    {
+        tasks.push_back([&, k] {
+            std::vector<uint32_t> fb(square ? 0 : len), tw;
+            const uint32_t p = nttPrimes[k];
+            uint32_t pinv = p;
+            for (size_t i = 0; i < 4; i++)
+            {
+                pinv *= 2 - p * pinv;
+            }
+            pinv = -pinv;
+
+            std::vector<uint32_t> &fa = res[k];
+            fa.assign(len, 0);
+            for (size_t i = 0; i < n; i++)
+            {
+                fa[i] = (uint32_t)(l.numeral[i / NTT_PIECES] >> (32 * (i % NTT_PIECES))) % p;
+            }
+            nttTwiddles(tw, len, p, nttRoots[k], false);
+            nttForward(fa.data(), len, tw.data(), p, pinv);
+            if (!square)
+            {
+                for (size_t i = 0; i < m; i++)
+                {
+                    fb[i] = (uint32_t)(r.numeral[i / NTT_PIECES] >> (32 * (i % NTT_PIECES))) % p;
+                }
+                nttForward(fb.data(), len, tw.data(), p, pinv);
+            }
+
+            //the pointwise product leaves a factor R^-1, fold R and len^-1 into one Montgomery multiplier
+            uint64_t rr = ((uint64_t)1 << 32) % p;
+            uint32_t scale = (uint32_t)(rr * rr % p * powMod(len, p - 2, p) % p);
+            const uint32_t *g = square ? fa.data() : fb.data();
+            for (size_t i = 0; i < len; i++)
+            {
+                fa[i] = montReduce((uint64_t)fa[i] * g[i], p, pinv);
+            }
+
+            nttTwiddles(tw, len, p, nttRoots[k], true);
+            nttInverse(fa.data(), len, tw.data(), p, pinv);
+            for (size_t i = 0; i < n + m; i++)
+            {
+                fa[i] = montReduce((uint64_t)fa[i] * scale, p, pinv);
+            }
+        });
+    }
+    runTasks(tasks, BigInt::parallel(std::min(n, m)));
+
+    //Garner's reconstruction, every coefficient is below p0 * p1 * p2 > 2^89
+    const uint64_t p0 = nttPrimes[0], p1 = nttPrimes[1], p2 = nttPrimes[2];
+    const uint64_t p01 = p0 * p1;
+    const uint64_t inv01 = powMod(p0, p1 - 2, p1);
+    const uint64_t inv012 = powMod(p01 % p2, p2 - 2, p2);
+    const uint64_t mask = 0xffffffff;
+
+    BigInt c;
+    c.numeral.assign((n + m) / NTT_PIECES, 0);
+    uint64_t carry = 0;
+    for (size_t i = 0; i < n + m; i++)
+    {
+        uint64_t a0 = res[0][i];
+        uint64_t a1 = (res[1][i] + p1 - a0 % p1) % p1 * inv01 % p1;
+        uint64_t x = a0 + p0 * a1;
+        uint64_t a2 = (res[2][i] + p2 - x % p2) % p2 * inv012 % p2;
+
+        //x + p01 * a2 as three words added to the running carry
+        uint64_t t = (p01 & mask) * a2 + (x & mask) + (carry & mask);
+        c.numeral[i / NTT_PIECES] |= (digit_t)(t & mask) << (32 * (i % NTT_PIECES));
+        carry = (t >> 32) + (p01 >> 32) * a2 + (x >> 32) + (carry >> 32);
+    }
+    c.trim();
+    c.sign = c.numeral.size() != 0 ? l.sign * r.sign : BigInt::SIGN_POS;
+    return c;
+}
+
+BigInt BigInt::mul(const BigInt &l, const BigInt &r)
+{
+    if (&l == &r)
+    {
+        return BigInt::sqr(l);
+    }
+
+    const BigInt &a = l.numeral.size() >= r.numeral.size() ? l : r;
+    const BigInt &b = l.numeral.size() >= r.numeral.size() ? r : l;
+    size_t n = a.numeral.size();
+    size_t m = b.numeral.size();
+
+    if (m < BigInt::KARATSUBA_THRESHOLD)
+    {
+        return BigInt::baseMul(a, b);
+    }
+
+    if (m >= BigInt::NTT_THRESHOLD && n + m <= BigInt::NTT_MAX_LENGTH)
+    {
+        return BigInt::nttMul(a, b);
+    }
+
+    if (n >= 2 * m)
+    {
+        //unbalanced, split the longer operand into pieces the size of the shorter one
+        BigInt c;
+        for (size_t i = 0; i < n; i += m)
+        {
+            c.addAbs(BigInt::mul(BigInt::slice(a, i, i + m), b), i);
+        }
+        c.trim();
+        c.sign = c.numeral.size() != 0 ? l.sign * r.sign : BigInt::SIGN_POS;
+        return c;
+    }
+
+    if (m < BigInt::TOOM3_THRESHOLD)
+    {
+        return BigInt::karatsubaMul(a, b);
+    }
+    if (m < BigInt::TOOM4_THRESHOLD)
+    {
+        return BigInt::toom3Mul(a, b);
+    }
+    return BigInt::toom4Mul(a, b);
+}
+
+BigInt BigInt::sqr(const BigInt &l)
+{
+    size_t n = l.numeral.size();
+
+    if (n < BigInt::KARATSUBA_SQR_THRESHOLD)
+    {
+        return BigInt::baseSqr(l);
+    }
+    if (n >= BigInt::NTT_SQR_THRESHOLD && 2 * n <= BigInt::NTT_MAX_LENGTH)
+    {
+        return BigInt::nttMul(l, l);
+    }
+    //the Toom tiers pass the same point to both sides of mul, which comes back here
+    if (n < BigInt::TOOM3_SQR_THRESHOLD)
+    {
+        return BigInt::karatsubaSqr(l);
+    }
+    if (n < BigInt::TOOM4_SQR_THRESHOLD)
+    {
+        return BigInt::toom3Mul(l, l);
+    }
+    return BigInt::toom4Mul(l, l);
+}
+
+//splits [0, n) into one range per thread when the batch holds enough digit operations
+void BigInt::batch(size_t n, size_t work, const std::function<void(size_t, size_t)> &f)
+{
+    TaskPool &pool = TaskPool::instance();
+    size_t parts = std::min(n, pool.size());
+    if (parts < 2 || work < BigInt::BATCH_PARALLEL_THRESHOLD || TaskPool::depth() >= BigInt::PARALLEL_DEPTH)
+    {
+        f(0, n);
+        return;
+    }
+
+    std::vector<std::function<void()>> tasks;
+    for (size_t p = 0; p < parts; p++)
+    {
+        size_t from = n * p / parts;
+        size_t to = n * (p + 1) / parts;
+        tasks.push_back([&f, from, to] { f(from, to); });
+    }
+    runTasks(tasks, true);
+}
+
+void BigInt::batch_mul(const BigInt *a, const BigInt *b, BigInt *r, size_t n)
+{
+    if (n == 0)
+    {
+        return;
+    }
+    size_t work = n * (a[0].numeral.size() + 1) * (b[0].numeral.size() + 1);
+    BigInt::batch(n, work, [a, b, r](size_t from, size_t to) {
+        for (size_t i = from; i < to; i++)
+        {
+            const BigInt &x = a[i];
+            const BigInt &y = b[i];
+            size_t xn = x.numeral.size();
+            size_t yn = y.numeral.size();
+            if (&r[i] == &x || &r[i] == &y || std::min(xn, yn) == 0 || std::min(xn, yn) >= BigInt::KARATSUBA_THRESHOLD)
+            {
+                r[i] = BigInt::mul(x, y);
+                continue;
+            }
+            r[i].numeral.resize_uninitialized(xn + yn);
+            mulBasecase(r[i].numeral.data(), x.numeral.data(), xn, y.numeral.data(), yn);
+            r[i].trim();
+            r[i].sign = x.sign * y.sign;
+        }
+    });
+}
+
+void BigInt::batch_add(const BigInt *a, const BigInt *b, BigInt *r, size_t n)
+{
+    if (n == 0)
+    {
+        return;
+    }
+    size_t work = n * (std::max(a[0].numeral.size(), b[0].numeral.size()) + 1);
+    BigInt::batch(n, work, [a, b, r](size_t from, size_t to) {
+        for (size_t i = from; i < to; i++)
+        {
+            if (&r[i] == &b[i])
+            {
+                r[i] += a[i];
+                continue;
+            }
+            //room for the carry up front, the copy then keeps it
+            r[i].numeral.reserve(std::max(a[i].numeral.size(), b[i].numeral.size()) + 1);
+            r[i] = a[i];
+            r[i] += b[i];
+        }
+    });
+}
+
+void BigInt::batch_sub(const BigInt *a, const BigInt *b, BigInt *r, size_t n)
+{
+    if (n == 0)
+    {
+        return;
+    }
+    size_t work = n * (std::max(a[0].numeral.size(), b[0].numeral.size()) + 1);
+    BigInt::batch(n, work, [a, b, r](size_t from, size_t to) {
+        for (size_t i = from; i < to; i++)
+        {
+            if (&r[i] == &b[i])
+            {
+                r[i] = a[i] - r[i];
+                continue;
+            }
+            r[i].numeral.reserve(std::max(a[i].numeral.size(), b[i].numeral.size()) + 1);
+            r[i] = a[i];
+            r[i] -= b[i];
+        }
+    });
+}
+
+BigInt &BigInt::operator*=(const BigInt &o)
+{
+    *this = &o == this ? BigInt::sqr(o) : BigInt::mul(*this, o);
+    return *this;
+}
+
+//number of leading zero bits of a non-zero digit
+static inline size_t nlz(digit_t d)
+{
+    return __builtin_clzll(d) - (sizeof(unsigned long long) - sizeof(digit_t)) * CHAR_BIT;
+}
+
+BigInt BigInt::slice(const BigInt &o, size_t from, size_t to)
+{
+    BigInt tmp;
+    to = std::min(to, o.numeral.size());
+    if (from < to)
+    {
+        tmp.numeral.assign(o.numeral.begin() + from, o.numeral.begin() + to);
+        tmp.trim();
+    }
+    return tmp;
+}
+
+//(hi * B + lo) / d with hi < d so that the quotient fits a digit
+static inline digit_t divWide(digit_t hi, digit_t lo, digit_t d, digit_t &rem)
+{
+#if BIGINT_DIGIT_BIT == 64 && defined(__x86_64__)
+    //a single divq, the compiler would call the generic 128 bit division
+    digit_t q;
+    __asm__("divq %4" : "=a"(q), "=d"(rem) : "a"(lo), "d"(hi), "rm"(d));
+    return q;
+#else
+    uddigit_t cur = ((uddigit_t)hi << (sizeof(digit_t) * CHAR_BIT)) | lo;
+    rem = (digit_t)(cur % d);
+    return (digit_t)(cur / d);
+#endif
+}
+
+digit_t BigInt::digitDiv(const BigInt &l, digit_t r, BigInt &q)
+{
+    size_t length = l.numeral.size();
+    q.numeral.resize(length);
+
+    digit_t rem = 0;
+    for (size_t i = length - 1; i < length; i--)
+    {
+        q.numeral[i] = divWide(rem, l.numeral[i], r, rem);
+    }
+    q.trim();
+    return rem;
+}
+
+digit_t BigInt::digitMod(const BigInt &l, digit_t r)
+{
+    size_t length = l.numeral.size();
+
+    digit_t rem = 0;
+    for (size_t i = length - 1; i < length; i--)
+    {
+        divWide(rem, l.numeral[i], r, rem);
+    }
+    return rem;
+}
+
+//Knuth, TAOCP vol. 2, 4.3.1, Algorithm D. Operates on magnitudes, |l| >= |r| and r has at least two digits.
+void BigInt::baseDiv(const BigInt &l, const BigInt &r, BigInt &q, BigInt &rem)
+{
+    size_t n = r.numeral.size();
+    size_t m = l.numeral.size() - n;
+
+    //D1: normalize so that the most significant bit of the divisor is set
+    size_t s = nlz(r.numeral[n - 1]);
+
+    SmallVector<digit_t, 2 * BigInt::INLINE_DIGITS> v(n, 0);
+    SmallVector<digit_t, 2 * BigInt::INLINE_DIGITS> u(m + n + 1, 0);
+    for (size_t i = n - 1; i > 0; i--)
+    {
+        v[i] = (r.numeral[i] << s) | (s ? r.numeral[i - 1] >> (BigInt::DIGIT_BIT - s) : 0);
+    }
+    v[0] = r.numeral[0] << s;
+
+    u[m + n] = s ? l.numeral[m + n - 1] >> (BigInt::DIGIT_BIT - s) : 0;
+    for (size_t i = m + n - 1; i > 0; i--)
+    {
+        u[i] = (l.numeral[i] << s) | (s ? l.numeral[i - 1] >> (BigInt::DIGIT_BIT - s) : 0);
+    }
+    u[0] = l.numeral[0] << s;
+
+    q.numeral.assign(m + 1, 0);
+
+    for (size_t j = m; j <= m; j--)
+    {
+        //D3: estimate qhat from the top two digits of the remainder and the top digit of the divisor
+        uddigit_t num = ((uddigit_t)u[j + n] << BigInt::DIGIT_BIT) | u[j + n - 1];
+        uddigit_t qhat = num / v[n - 1];
+        uddigit_t rhat = num % v[n - 1];
+
+        while (qhat > BigInt::DIGIT_MAX || qhat * v[n - 2] > ((rhat << BigInt::DIGIT_BIT) | u[j + n - 2]))
+        {
+            qhat--;
+            rhat += v[n - 1];
+            if (rhat > BigInt::DIGIT_MAX)
+            {
+                break;
+            }
+        }
+
+        //D4: multiply and subtract
+        digit_t borrow = subMul1(u.data() + j, v.data(), n, (digit_t)qhat);
+        digit_t top = u[j + n];
+        u[j + n] = top - borrow;
+
+        //D6: qhat was one too large, add back
+        if (top < borrow)
+        {
+            qhat--;
+            u[j + n] += addN(u.data() + j, u.data() + j, v.data(), n);
+        }
+        q.numeral[j] = qhat;
+    }
+    q.trim();
+
+    //D8: unnormalize the remainder
+    rem.numeral.resize(n);
+    for (size_t i = 0; i < n - 1; i++)
+    {
+        rem.numeral[i] = (u[i] >> s) | (s ? u[i + 1] << (BigInt::DIGIT_BIT - s) : 0);
+    }
+    rem.numeral[n - 1] = u[n - 1] >> s;
+    rem.trim();
+}
+
+//Burnikel and Ziegler, Fast Recursive Division, 1998.
+//l < r * B^n, r has exactly n digits and is normalized.
+void BigInt::div2n1n(const BigInt &l, const BigInt &r, size_t n, BigInt &q, BigInt &rem)
+{
+    if ((n % 2) == 1 || n < BigInt::BURNIKEL_ZIEGLER_THRESHOLD)
+    {
+        if (BigInt::cmp(l, r) < 0)
+        {
+            q = BigInt();
+            rem = l;
+        }
+        else
+        {
+            BigInt::baseDiv(l, r, q, rem);
+        }
+        return;
+    }
+
+    size_t k = n / 2;
+    BigInt q1, q2, r1;
+
+    BigInt::div3n2n(BigInt::slice(l, k, 4 * k), r, k, q1, r1);
+    r1 <<= k * BigInt::DIGIT_BIT;
+    r1 += BigInt::slice(l, 0, k);
+    BigInt::div3n2n(r1, r, k, q2, rem);
+
+    q1 <<= k * BigInt::DIGIT_BIT;
+    q1 += q2;
+    q = std::move(q1);
+}
+
+//l < r * B^n, r has exactly 2n digits and is normalized.
+void BigInt::div3n2n(const BigInt &l, const BigInt &r, size_t n, BigInt &q, BigInt &rem)
+{
+    BigInt l1 = BigInt::slice(l, 2 * n, 3 * n);
+    BigInt r1 = BigInt::slice(r, n, 2 * n);
+    BigInt r2 = BigInt::slice(r, 0, n);
+
+    BigInt c;
+    if (BigInt::cmp(l1, r1) < 0)
+    {
+        BigInt::div2n1n(BigInt::slice(l, n, 3 * n), r1, n, q, c);
+    }
+    else
+    {
+        //the quotient digit block saturates at B^n - 1
+        q = BigInt();
+        q.numeral.assign(n, BigInt::DIGIT_MAX);
+        c = BigInt::slice(l, n, 3 * n) - (r1 << n * BigInt::DIGIT_BIT) + r1;
+    }
+
+    BigInt d = q * r2;
+    c <<= n * BigInt::DIGIT_BIT;
+    c += BigInt::slice(l, 0, n);
+    c -= d;
+
+    while (c.sign == BigInt::SIGN_NEG && c.numeral.size() != 0)
+    {
+        --q;
+        c += r;
+    }
+    rem = std::move(c);
+}
+
+void BigInt::burnikelZieglerDiv(const BigInt &l, const BigInt &r, BigInt &q, BigInt &rem)
+{
+    size_t s = r.numeral.size();
+
+    //block size n = j * 2^k so that the recursion halves n down to below the threshold
+    size_t m = 1;
+    while (m * BigInt::BURNIKEL_ZIEGLER_THRESHOLD <= s)
+    {
+        m <<= 1;
+    }
+    size_t j = (s + m - 1) / m;
+    size_t n = j * m;
+
+    //normalize the divisor to exactly n digits with its most significant bit set
+    size_t sigma = (n - s) * BigInt::DIGIT_BIT + nlz(r.numeral[s - 1]);
+    BigInt a = BigInt(l).abs() << sigma;
+    BigInt b = BigInt(r).abs() << sigma;
+
+    //number of n digit blocks in a, the top block must have its most significant bit clear
+    size_t t = std::max<size_t>(2, (a.numeral.size() + n) / n);
+
+    q = BigInt();
+    q.numeral.assign((t - 1) * n, 0);
+
+    BigInt z = BigInt::slice(a, (t - 2) * n, t * n);
+    for (size_t i = t - 2; i < t; i--)
+    {
+        BigInt qi, ri;
+        BigInt::div2n1n(z, b, n, qi, ri);
+        std::copy(qi.numeral.begin(), qi.numeral.end(), q.numeral.begin() + i * n);
+        if (i > 0)
+        {
+            ri <<= n * BigInt::DIGIT_BIT;
+            ri += BigInt::slice(a, (i - 1) * n, i * n);
+            z = std::move(ri);
+        }
+        else
+        {
+            rem = ri >> sigma;
+        }
+    }
+    q.trim();
+}
+
+std::pair<BigInt, BigInt> BigInt::divmod(const BigInt &l, const BigInt &r)
+{
+    if (r.numeral.size() == 0)
+    {
+        throw std::domain_error("BigInt: division by zero");
+    }
+
+    BigInt q, rem;
+
+    size_t n = l.numeral.size();
+    size_t m = r.numeral.size();
+
+    if (BigInt::cmpAbs(l, r) < 0)
+    {
+        rem = l;
+        return std::make_pair(std::move(q), std::move(rem));
+    }
+
+    if (m == 1)
+    {
+        digit_t d = BigInt::digitDiv(l, r.numeral[0], q);
+        if (d != 0)
+        {
+            rem.numeral.push_back(d);
+        }
+    }
+    else if (m >= BigInt::BURNIKEL_ZIEGLER_THRESHOLD && (n - m) >= BigInt::BURNIKEL_ZIEGLER_OFFSET)
+    {
+        BigInt::burnikelZieglerDiv(l, r, q, rem);
+    }
+    else
+    {
+        BigInt::baseDiv(l, r, q, rem);
+    }
+
+    //truncated division: the quotient rounds toward zero and the remainder takes the sign of the dividend
+    q.sign = q.numeral.size() != 0 ? l.sign * r.sign : BigInt::SIGN_POS;
+    rem.sign = rem.numeral.size() != 0 ? l.sign : BigInt::SIGN_POS;
+
+    return std::make_pair(std::move(q), std::move(rem));
+}
+
+BigInt &BigInt::operator/=(const BigInt &o)
+{
+    *this = std::move(BigInt::divmod(*this, o).first);
+    return *this;
+}
+
+BigInt &BigInt::operator%=(const BigInt &o)
+{
+    *this = std::move(BigInt::divmod(*this, o).second);
+    return *this;
+}
+
+std::pair<BigInt, ddigit_t> BigInt::divmod(const BigInt &l, ddigit_t r)
+{
+    uddigit_t m = magnitude(r);
+    if (m == 0 || m > BigInt::DIGIT_MAX)
+    {
+        std::pair<BigInt, BigInt> qr = BigInt::divmod(l, BigInt(r));
+
+        //|remainder| < |r|, so it fits in a double digit
+        uddigit_t v = 0;
+        size_t length = qr.second.numeral.size();
+        for (size_t i = length - 1; i < length; i--)
+        {
+            v = (v << BigInt::DIGIT_BIT) | qr.second.numeral[i];
+        }
+        ddigit_t rem = l.sign == BigInt::SIGN_NEG ? -(ddigit_t)v : (ddigit_t)v;
+        return std::make_pair(std::move(qr.first), rem);
+    }
+
+    BigInt q;
+    ddigit_t rem = BigInt::digitDiv(l, m, q);
+    if (q.numeral.size() != 0)
+    {
+        q.sign = r < 0 ? -l.sign : l.sign;
+    }
+    return std::make_pair(std::move(q), l.sign == BigInt::SIGN_NEG ? -rem : rem);
+}
+
+BigInt &BigInt::operator/=(const ddigit_t o)
+{
+    uddigit_t m = magnitude(o);
+    if (m == 0 || m > BigInt::DIGIT_MAX)
+    {
+        return *this /= BigInt(o);
+    }
+
+    BigInt::digitDiv(*this, m, *this);
+    if (this->numeral.size() == 0)
+    {
+        this->sign = BigInt::SIGN_POS;
+    }
+    else if (o < 0)
+    {
+        this->sign = -this->sign;
+    }
+    return *this;
+}
+
+BigInt &BigInt::operator%=(const ddigit_t o)
+{
+    uddigit_t m = magnitude(o);
+    if (m == 0 || m > BigInt::DIGIT_MAX)
+    {
+        return *this %= BigInt(o);
+    }
+
+    digit_t d = BigInt::digitMod(*this, m);
+    this->numeral.clear();
+    if (d != 0)
+    {
+        this->numeral.push_back(d);
+    }
+    else
+    {
+        this->sign = BigInt::SIGN_POS;
+    }
+    return *this;
+}
+
+BigInt BigInt::pow(const BigInt &l, size_t e)
+{
+    //left to right square and multiply, 0^0 is 1
+    size_t i = sizeof(size_t) * CHAR_BIT;
+    while (i > 0 && ((e >> (i - 1)) & 1) == 0)
+    {
+        i--;
+    }
+
+    BigInt r(1);
+    while (i > 0)
+    {
+        r = BigInt::sqr(r);
+        if ((e >> --i) & 1)
+        {
+            r = BigInt::mul(r, l);
+        }
+    }
+    return r;
+}
+
+BigInt BigInt::powmod(const BigInt &b, const BigInt &e, const BigInt &m)
+{
+    //the last few moduli used by this thread keep their contexts, so repeated calls skip the setup. A hit
+    //moves to the front, a miss drops the least recently used context when the cache is full.
+    static thread_local std::deque<ModContext> contexts;
+    for (std::deque<ModContext>::iterator it = contexts.begin(); it != contexts.end(); ++it)
+    {
+        if (it->modulus() == m)
+        {
+            std::rotate(contexts.begin(), it, it + 1);
+            return contexts.front().powmod(b, e);
+        }
+    }
+    {
+        CacheAllocation scope;
+        if (contexts.size() == BigInt::MOD_CONTEXT_CACHE)
+        {
+            contexts.pop_back();
+        }
+        contexts.emplace_front(m);
+    }
+    return contexts.front().powmod(b, e);
+}
+
+//Montgomery arithmetic on residues of exactly n digits modulo an odd m. Products land in t through the
+//basecase or the Karatsuba spans, redc then divides by R = B^n and leaves a value below m. Every
+//temporary lives in a caller provided workspace of Montgomery::workspace(n, threshold) digits.
+class Montgomery
+{
+  private:
+    const digit_t *m;
+    size_t n;
+    digit_t ninv;
+    size_t threshold;
+    digit_t *t;
+    digit_t *s;
+    digit_t *scratch;
+
+    void redc(digit_t *r)
+    {
+        digit_t *t = this->t;
+        size_t n = this->n;
+
+        //each step clears digit i of t, the carry out of digit i + n rides along in top
+        digit_t top = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            digit_t c = addMul1(t + i, this->m, n, t[i] * this->ninv);
+            digit_t d = t[i + n] + top;
+            top = d < top;
+            d += c;
+            top += d < c;
+            t[i + n] = d;
+        }
+
+        //t / R < 2m, subtract m unless that borrows past top. Selected with a mask, not a branch.
+        digit_t borrow = subN(this->s, t + n, this->m, n);
+        digit_t mask = (top ^ borrow) - 1;
+        for (size_t i = 0; i < n; i++)
+        {
+            r[i] = (this->s[i] & mask) | (t[i + n] & ~mask);
+        }
+    }
+
+    inline bool useKaratsuba() const
+    {
+        return this->threshold != 0 && this->n >= this->threshold;
+    }
+
+  public:
+    static size_t workspace(size_t n, size_t threshold)
+    {
+        return 3 * n + (threshold != 0 && n >= threshold ? karatsubaScratch(n, threshold) : 0);
+    }
+
+    //threshold 0 keeps every product on the basecase, whose running time does not depend on the operands
+    Montgomery(const digit_t *m, size_t n, digit_t ninv, size_t threshold, digit_t *work)
+        : m(m), n(n), ninv(ninv), threshold(threshold), t(work), s(work + 2 * n), scratch(work + 3 * n)
+    {
+    }
+
+    //r = a * b / R, r may be a or b
+    void mul(digit_t *r, const digit_t *a, const digit_t *b)
+    {
+        if (this->useKaratsuba())
+        {
+            karatsuba(this->t, a, this->n, b, this->n, this->scratch, this->threshold);
+        }
+        else
+        {
+            mulBasecase(this->t, a, this->n, b, this->n);
+        }
+        this->redc(r);
+    }
+
+    void sqr(digit_t *r, const digit_t *a)
+    {
+        if (this->useKaratsuba())
+        {
+            karatsubaSquare(this->t, a, this->n, this->scratch, this->threshold);
+        }
+        else
+        {
+            sqrBasecase(this->t, a, this->n);
+        }
+        this->redc(r);
+    }
+
+    //r = a / R, takes a value out of Montgomery form
+    void reduce(digit_t *r, const digit_t *a)
+    {
+        std::copy(a, a + this->n, this->t);
+        std::fill(this->t + this->n, this->t + 2 * this->n, 0);
+        this->redc(r);
+    }
+};
+
+//n digit copy of a value below B^n, zero padded
+static std::vector<digit_t> padded(const digit_t *a, size_t an, size_t n)
+{
+    std::vector<digit_t> v(n);
+    std::copy(a, a + an, v.begin());
+    return v;
+}
+
+//bits [pos, pos + w) of the n digit number e, w < DIGIT_BIT, anything past the top digit reads as zero
+static inline digit_t bitField(const digit_t *e, size_t n, size_t pos, size_t w)
+{
+    const size_t bits = sizeof(digit_t) * CHAR_BIT;
+    size_t i = pos / bits;
+    size_t s = pos % bits;
+    if (i >= n)
+    {
+        return 0;
+    }
+    digit_t v = e[i] >> s;
+    if (s + w > bits && i + 1 < n)
+    {
+        v |= e[i + 1] << (bits - s);
+    }
+    return v & (((digit_t)1 << w) - 1);
+}
+
+//Left to right sliding window, g is the base and e is trimmed and non-zero. The window grows with the
+//exponent so that the 2^(w-1) odd powers in the table stay a small fraction of the multiplications.
+template <typename T, typename Mul, typename Sqr>
+static T slidingWindow(const T &g, const digit_t *e, size_t en, Mul mul, Sqr sqr)
+{
+    size_t bits = en * sizeof(digit_t) * CHAR_BIT - nlz(e[en - 1]);
+    size_t w = bits > 671 ? 6 : bits > 239 ? 5 : bits > 79 ? 4 : bits > 23 ? 3 : 1;
+
+    //g, g^3, g^5, ..., g^(2^w - 1)
+    std::vector<T> odd(1, g);
+    if (w > 1)
+    {
+        T g2 = g;
+        sqr(g2, g);
+        odd.resize((size_t)1 << (w - 1), g);
+        for (size_t k = 1; k < odd.size(); k++)
+        {
+            mul(odd[k], odd[k - 1], g2);
+        }
+    }
+
+    //the top bit is set, so the first window seeds the result
+    T acc = g;
+    bool first = true;
+    size_t i = bits;
+    while (i > 0)
+    {
+        if (bitField(e, en, i - 1, 1) == 0)
+        {
+            sqr(acc, acc);
+            i--;
+            continue;
+        }
+
+        //longest window [j, i) of at most w bits that ends in a set bit
+        size_t j = i > w ? i - w : 0;
+        while (bitField(e, en, j, 1) == 0)
+        {
+            j++;
+        }
+        digit_t v = bitField(e, en, j, i - j);
+        if (first)
+        {
+            acc = odd[v >> 1];
+            first = false;
+        }
+        else
+        {
+            for (size_t k = j; k < i; k++)
+            {
+                sqr(acc, acc);
+            }
+            mul(acc, acc, odd[v >> 1]);
+        }
+        i = j;
+    }
+    return acc;
+}
+
+ModContext::ModContext(const BigInt &m) : m(m), n(m.numeral.size()), ninv(0)
+{
+    if (m.sign == BigInt::SIGN_NEG || m.numeral.size() == 0)
+    {
+        throw std::invalid_argument("ModContext: modulus must be positive");
+    }
+
+    BigInt r = BigInt(1) << this->n * BigInt::DIGIT_BIT;
+    this->one = r % m;
+    this->r2 = BigInt::sqr(this->one) % m;
+    this->mu = BigInt::sqr(r) / m;
+
+    //Newton iteration for m^-1 mod B, m0 is its own inverse to 3 bits and each step doubles that
+    digit_t m0 = m.numeral[0];
+    if (m0 & 1)
+    {
+        digit_t x = m0;
+        for (size_t bits = 3; bits < BigInt::DIGIT_BIT; bits *= 2)
+        {
+            x *= 2 - m0 * x;
+        }
+        this->ninv = -x;
+    }
+}
+
+//x mod m in [0, m)
+BigInt ModContext::residue(const BigInt &x) const
+{
+    BigInt r = BigInt(x).abs();
+    r = r.numeral.size() <= 2 * this->n ? this->reduce(r) : r % this->m;
+    if (x.sign == BigInt::SIGN_NEG && r.numeral.size() != 0)
+    {
+        r = this->m - r;
+    }
+    return r;
+}
+
+//Barrett reduction of 0 <= x < B^2n, the quotient estimate is at most two below the true one
+BigInt ModContext::reduce(const BigInt &x) const
+{
+    size_t n = this->n;
+    BigInt q = BigInt::slice(BigInt::mul(BigInt::slice(x, n - 1, 2 * n), this->mu), n + 1, 2 * n + 2);
+    BigInt r = x - BigInt::mul(q, this->m);
+    while (BigInt::cmp(r, this->m) >= 0)
+    {
+        r -= this->m;
+    }
+    return r;
+}
+
+//per thread workspace of the Montgomery kernels, kept across calls so that modular operations do not allocate
+static digit_t *montgomeryWork(size_t size)
+{
+    static thread_local std::vector<digit_t> work;
+    if (work.size() < size)
+    {
+        work.resize(size);
+    }
+    return work.data();
+}
+
+//a * b / R for residues of at most n digits, the operands are zero padded into the workspace
+BigInt ModContext::montMul(const BigInt &a, const BigInt &b) const
+{
+    size_t n = this->n;
+    size_t size = Montgomery::workspace(n, BigInt::KARATSUBA_THRESHOLD);
+    digit_t *work = montgomeryWork(size + 2 * n);
+    digit_t *x = work + size;
+    digit_t *y = x + n;
+    std::fill(std::copy(a.numeral.begin(), a.numeral.end(), x), x + n, 0);
+
+    Montgomery mont(this->m.numeral.data(), n, this->ninv, BigInt::KARATSUBA_THRESHOLD, work);
+    if (&a == &b)
+    {
+        mont.sqr(x, x);
+    }
+    else
+    {
+        std::fill(std::copy(b.numeral.begin(), b.numeral.end(), y), y + n, 0);
+        mont.mul(x, x, y);
+    }
+
+    BigInt r;
+    r.numeral.assign(x, x + n);
+    r.trim();
+    return r;
+}
+
+BigInt ModContext::toMontgomery(const BigInt &x) const
+{
+    BigInt r = this->residue(x);
+    return this->odd() ? this->montMul(r, this->r2) : r;
+}
+
+BigInt ModContext::fromMontgomery(const BigInt &a) const
+{
+    return this->odd() ? this->montMul(a, BigInt(1)) : a;
+}
+
+BigInt ModContext::mulmod(const BigInt &a, const BigInt &b) const
+{
+    return this->odd() ? this->montMul(a, b) : this->reduce(BigInt::mul(a, b));
+}
+
+BigInt ModContext::sqrmod(const BigInt &a) const
+{
+    return this->odd() ? this->montMul(a, a) : this->reduce(BigInt::sqr(a));
+}
+
+BigInt ModContext::addmod(const BigInt &a, const BigInt &b) const
+{
+    BigInt r = a + b;
+    if (BigInt::cmp(r, this->m) >= 0)
+    {
+        r -= this->m;
+    }
+    return r;
+}
+
+BigInt ModContext::submod(const BigInt &a, const BigInt &b) const
+{
+    BigInt r = a - b;
+    if (r.sign == BigInt::SIGN_NEG)
+    {
+        r += this->m;
+    }
+    return r;
+}
+
+//a = x * R, so the Montgomery form of x^-1 is a^-1 * R^2, two multiplications by R^2 away
+BigInt ModContext::inv(const BigInt &a) const
+{
+    BigInt y = BigInt::modinv(a, this->m);
+    return this->odd() ? this->montMul(this->montMul(y, this->r2), this->r2) : y;
+}
+
+BigInt ModContext::powmod(const BigInt &b, const BigInt &e) const
+{
+    if (e.sign == BigInt::SIGN_NEG)
+    {
+        throw std::invalid_argument("ModContext: exponent must be non-negative");
+    }
+
+    if (e.numeral.size() == 0)
+    {
+        return this->residue(1);
+    }
+
+    const digit_t *ed = e.numeral.data();
+    size_t en = e.numeral.size();
+    size_t n = this->n;
+
+    if (!this->odd())
+    {
+        auto mul = [this](BigInt &r, const BigInt &x, const BigInt &y) { r = this->reduce(BigInt::mul(x, y)); };
+        auto sqr = [this](BigInt &r, const BigInt &x) { r = this->reduce(BigInt::sqr(x)); };
+        return slidingWindow(this->residue(b), ed, en, mul, sqr);
+    }
+
+    BigInt g = this->toMontgomery(b);
+
+    typedef std::vector<digit_t> Residue;
+    size_t size = Montgomery::workspace(n, BigInt::KARATSUBA_THRESHOLD);
+    Montgomery mont(this->m.numeral.data(), n, this->ninv, BigInt::KARATSUBA_THRESHOLD, montgomeryWork(size));
+    auto mul = [&mont](Residue &r, const Residue &x, const Residue &y) { mont.mul(r.data(), x.data(), y.data()); };
+    auto sqr = [&mont](Residue &r, const Residue &x) { mont.sqr(r.data(), x.data()); };
+
+    Residue acc = slidingWindow(padded(g.numeral.data(), g.numeral.size(), n), ed, en, mul, sqr);
+    mont.reduce(acc.data(), acc.data());
+
+    BigInt r;
+    r.numeral.assign(acc.data(), acc.data() + n);
+    r.trim();
+    return r;
+}
+
+BigInt ModContext::powmodSec(const BigInt &b, const BigInt &e) const
+{
+    if (e.sign == BigInt::SIGN_NEG)
+    {
+        throw std::invalid_argument("ModContext: exponent must be non-negative");
+    }
+    if (!this->odd())
+    {
+        throw std::invalid_argument("ModContext: powmodSec needs an odd modulus");
+    }
+
+    const size_t w = 4;
+    const size_t entries = (size_t)1 << w;
+    const size_t bits = sizeof(digit_t) * CHAR_BIT;
+    size_t n = this->n;
+
+    //table[k] = g^k in Montgomery form
+    std::vector<digit_t> table(entries * n);
+    std::copy(this->one.numeral.begin(), this->one.numeral.end(), table.begin());
+
+    //g = b * R^2 / R on zero padded operands: b < R and R^2 mod m < m keep the product below m * R, so
+    //the reduction lands in [0, m) without a division. Other bases are reduced first, in variable time.
+    Montgomery mont(this->m.numeral.data(), n, this->ninv, 0, montgomeryWork(Montgomery::workspace(n, 0)));
+    std::vector<digit_t> base(n), r2(n);
+    BigInt reduced;
+    const BigInt *c = &b;
+    if (b.sign == BigInt::SIGN_NEG || b.numeral.size() > n)
+    {
+        reduced = this->residue(b);
+        c = &reduced;
+    }
+    std::copy(c->numeral.begin(), c->numeral.end(), base.begin());
+    std::copy(this->r2.numeral.begin(), this->r2.numeral.end(), r2.begin());
+    mont.mul(&table[n], base.data(), r2.data());
+
+    for (size_t k = 2; k < entries; k++)
+    {
+        mont.mul(&table[k * n], &table[(k - 1) * n], &table[n]);
+    }
+
+    std::vector<digit_t> acc(table.begin(), table.begin() + n);
+    std::vector<digit_t> sel(n);
+    const digit_t *ed = e.numeral.data();
+    size_t en = e.numeral.size();
+    for (size_t i = (en * bits + w - 1) / w; i-- > 0;)
+    {
+        for (size_t k = 0; k < w; k++)
+        {
+            mont.sqr(acc.data(), acc.data());
+        }
+
+        //read every entry and keep the one that matches, mask is all ones only when k == v
+        digit_t v = bitField(ed, en, i * w, w);
+        std::fill(sel.begin(), sel.end(), 0);
+        for (size_t k = 0; k < entries; k++)
+        {
+            digit_t d = k ^ v;
+            digit_t mask = ((d | (0 - d)) >> (bits - 1)) - 1;
+            for (size_t j = 0; j < n; j++)
+            {
+                sel[j] |= table[k * n + j] & mask;
+            }
+        }
+        mont.mul(acc.data(), acc.data(), sel.data());
+    }
+    mont.reduce(acc.data(), acc.data());
+
+    BigInt r;
+    r.numeral.assign(acc.data(), acc.data() + n);
+    r.trim();
+    return r;
+}
+
+//(a, b) = m * (a', b') for the (a', b') a run of Euclid steps left behind, m = {m00, m01, m10, m11}.
+//The entries are non-negative and det(m) = det.
+struct BigInt::Cofactors
+{
+    BigInt m[4];
+    int det;
+
+    Cofactors() : m{1, 0, 0, 1}, det(1) {}
+
+    //m = m * o
+    void mul(const Cofactors &o)
+    {
+        for (size_t r = 0; r < 4; r += 2)
+        {
+            BigInt e0 = this->m[r] * o.m[0] + this->m[r + 1] * o.m[2];
+            BigInt e1 = this->m[r] * o.m[1] + this->m[r + 1] * o.m[3];
+            this->m[r] = std::move(e0);
+            this->m[r + 1] = std::move(e1);
+        }
+        this->det *= o.det;
+    }
+};
+
+static inline size_t bitLength(const digit_t *d, size_t n)
+{
+    return n == 0 ? 0 : n * sizeof(digit_t) * CHAR_BIT - nlz(d[n - 1]);
+}
+
+static inline size_t ntz(uddigit_t x)
+{
+    const size_t bits = sizeof(digit_t) * CHAR_BIT;
+    size_t n = 0;
+    while (((digit_t)x) == 0)
+    {
+        x >>= bits;
+        n += bits;
+    }
+    return n + __builtin_ctzll((digit_t)x);
+}
+
+//Stein's binary GCD on values of up to two digits
+static uddigit_t binaryGcd(uddigit_t u, uddigit_t v)
+{
+    if (u == 0 || v == 0)
+    {
+        return u | v;
+    }
+    size_t shift = ntz(u | v);
+    u >>= ntz(u);
+    do
+    {
+        v >>= ntz(v);
+        if (u > v)
+        {
+            std::swap(u, v);
+        }
+        v -= u;
+    } while (v != 0);
+    return u << shift;
+}
+
+//x * p + y * q for non-negative p and q, one multiply pass and one multiply-accumulate pass over the digits
+BigInt BigInt::combine(const BigInt &p, ddigit_t x, const BigInt &q, ddigit_t y)
+{
+    bool longer = p.numeral.size() >= q.numeral.size();
+    const BigInt &l = longer ? p : q;
+    const BigInt &s = longer ? q : p;
+    ddigit_t lx = longer ? x : y;
+    ddigit_t sx = longer ? y : x;
+    size_t n = l.numeral.size();
+    size_t m = s.numeral.size();
+
+    BigInt r;
+    r.numeral.resize(n + 1);
+    digit_t *d = r.numeral.data();
+    d[n] = mul1(d, l.numeral.data(), n, magnitude(lx));
+    r.sign = (lx != 0 ? lx : sx) < 0 ? BigInt::SIGN_NEG : BigInt::SIGN_POS;
+    if (lx == 0 || sx == 0 || (lx < 0) == (sx < 0))
+    {
+        add1(d + m, n + 1 - m, addMul1(d, s.numeral.data(), m, magnitude(sx)));
+    }
+    else if (sub1(d + m, n + 1 - m, subMul1(d, s.numeral.data(), m, magnitude(sx))) != 0)
+    {
+        //went below zero, take the two's complement
+        negate(d, n + 1);
+        r.sign = -r.sign;
+    }
+    r.trim();
+    if (r.numeral.size() == 0)
+    {
+        r.sign = BigInt::SIGN_POS;
+    }
+    return r;
+}
+
+//signed double digit for the leading bits in Lehmer's step
+#if BIGINT_DIGIT_BIT == 64
+__extension__ typedef __int128 sddigit_t;
+#else
+typedef int64_t sddigit_t;
+#endif
+
+//Lehmer's step, Knuth TAOCP vol. 2, 4.5.2, Algorithm L, for a >= b > 0, on double digit approximations
+//as in Jebelean's double digit variant. The Euclid steps run on the leading 2 * DIGIT_BIT - 2 bits of
+//a and b for as long as both bounds on the quotient agree and the cofactors stay below 2^(DIGIT_BIT - 2),
+//which lets one step strip about a digit. The cofactors are then applied to the full numbers in one pass.
+//When no quotient can be trusted it falls back to one full division step.
+void BigInt::lehmerStep(BigInt &a, BigInt &b, Cofactors *c)
+{
+    const size_t w = BigInt::DIGIT_BIT - 1;
+    const ddigit_t limit = (ddigit_t)1 << (BigInt::DIGIT_BIT - 2);
+    size_t n = bitLength(a.numeral.data(), a.numeral.size());
+    size_t shift = n > 2 * w ? n - 2 * w : 0;
+    const digit_t *ad = a.numeral.data();
+    const digit_t *bd = b.numeral.data();
+    size_t an = a.numeral.size();
+    size_t bn = b.numeral.size();
+    sddigit_t x = ((sddigit_t)bitField(ad, an, shift + w, w) << w) | bitField(ad, an, shift, w);
+    sddigit_t y = ((sddigit_t)bitField(bd, bn, shift + w, w) << w) | bitField(bd, bn, shift, w);
+
+    //the signs of the cofactors alternate, so |A - q * C| = |A| + q * |C|
+    ddigit_t A = 1, B = 0, C = 0, D = 1;
+    int det = 1;
+    while (y + C > 0 && y + D > 0)
+    {
+        sddigit_t q = (x + A) / (y + C);
+        if (q != (x + B) / (y + D))
+        {
+            break;
+        }
+        ddigit_t ac = A < 0 ? -A : A, cc = C < 0 ? -C : C;
+        ddigit_t bc = B < 0 ? -B : B, dc = D < 0 ? -D : D;
+        if ((cc != 0 && q > (limit - ac) / cc) || q > (limit - bc) / dc)
+        {
+            break;
+        }
+        ddigit_t t = A - (ddigit_t)q * C;
+        A = C;
+        C = t;
+        t = B - (ddigit_t)q * D;
+        B = D;
+        D = t;
+        sddigit_t r = x - q * y;
+        x = y;
+        y = r;
+        det = -det;
+    }
+
+    if (B == 0)
+    {
+        std::pair<BigInt, BigInt> qr = BigInt::divmod(a, b);
+        if (c != nullptr)
+        {
+            //m * [[q, 1], [1, 0]]
+            for (size_t r = 0; r < 4; r += 2)
+            {
+                BigInt e = c->m[r] * qr.first + c->m[r + 1];
+                c->m[r + 1] = std::move(c->m[r]);
+                c->m[r] = std::move(e);
+            }
+            c->det = -c->det;
+        }
+        a = std::move(b);
+        b = std::move(qr.second);
+        return;
+    }
+
+    BigInt na = BigInt::combine(a, A, b, B);
+    BigInt nb = BigInt::combine(a, C, b, D);
+    if (c != nullptr)
+    {
+        //m * [[A, B], [C, D]]^-1, the inverse is det * [[D, -B], [-C, A]]
+        for (size_t r = 0; r < 4; r += 2)
+        {
+            BigInt e0 = BigInt::combine(c->m[r], det * D, c->m[r + 1], -det * C);
+            BigInt e1 = BigInt::combine(c->m[r], -det * B, c->m[r + 1], det * A);
+            c->m[r] = std::move(e0);
+            c->m[r + 1] = std::move(e1);
+        }
+        c->det *= det;
+    }
+    a = std::move(na);
+    b = std::move(nb);
+}
+
+//Euclid steps on a >= b >= 0 until b < 2^s, accumulating the cofactors into c when it is set.
+//Large operands strip their bits in bites through the half GCD: the quotients of the top 2j bits of a
+//and b match those of a and b until the remainders get down to about j bits, so a recursive call on the
+//top halves yields the cofactors of j bits worth of steps, which are then applied to the full numbers
+//with fast multiplication. The call runs until a digit above j bits to stay clear of the quotients that
+//differ. A bite whose cofactors turn a or b negative all the same is dropped for a Lehmer step.
+void BigInt::gcdReduce(BigInt &a, BigInt &b, size_t s, Cofactors *c)
+{
+    while (bitLength(b.numeral.data(), b.numeral.size()) > s)
+    {
+        //down to two digits with no cofactors to track, finish with the binary GCD
+        if (c == nullptr && s == 0 && a.numeral.size() <= 2)
+        {
+            uddigit_t u = a.numeral[0] | (a.numeral.size() > 1 ? (uddigit_t)a.numeral[1] << BigInt::DIGIT_BIT : 0);
+            uddigit_t v = b.numeral[0] | (b.numeral.size() > 1 ? (uddigit_t)b.numeral[1] << BigInt::DIGIT_BIT : 0);
+            uddigit_t g = binaryGcd(u, v);
+            a.numeral.assign(1, (digit_t)g);
+            a.numeral.push_back((digit_t)(g >> BigInt::DIGIT_BIT));
+            a.trim();
+            b = BigInt();
+            return;
+        }
+
+        size_t n = bitLength(a.numeral.data(), a.numeral.size());
+        size_t j = (n - s) / 2;
+        if (a.numeral.size() >= BigInt::HGCD_THRESHOLD && j > 2 * BigInt::DIGIT_BIT)
+        {
+            size_t h = n - 2 * j;
+            if (h == 0)
+            {
+                //the top 2j bits are all of a, reduce in place unless b is already that short
+                if (bitLength(b.numeral.data(), b.numeral.size()) > j + BigInt::DIGIT_BIT)
+                {
+                    BigInt::gcdReduce(a, b, j + BigInt::DIGIT_BIT, c);
+                    continue;
+                }
+            }
+            else
+            {
+                BigInt a1 = a >> h;
+                BigInt b1 = b >> h;
+                Cofactors c1;
+                BigInt::gcdReduce(a1, b1, j + BigInt::DIGIT_BIT, &c1);
+
+                //(a', b') = m^-1 * (a, b) with the inverse det * [[m11, -m01], [-m10, m00]]. The top parts
+                //are already reduced to (a1, b1), only the low h bits are left to multiply.
+                BigInt al = a - (a >> h << h);
+                BigInt bl = b - (b >> h << h);
+                const BigInt *m = c1.m;
+                BigInt na = m[3] * al - m[1] * bl;
+                BigInt nb = m[0] * bl - m[2] * al;
+                if (c1.det < 0)
+                {
+                    na = -std::move(na);
+                    nb = -std::move(nb);
+                }
+                na += a1 << h;
+                nb += b1 << h;
+                if (na.sign == BigInt::SIGN_POS && nb.sign == BigInt::SIGN_POS && c1.m[1].numeral.size() != 0)
+                {
+                    if (BigInt::cmpAbs(na, nb) < 0)
+                    {
+                        //swap the columns to keep a' >= b'
+                        std::swap(na, nb);
+                        std::swap(c1.m[0], c1.m[1]);
+                        std::swap(c1.m[2], c1.m[3]);
+                        c1.det = -c1.det;
+                    }
+                    a = std::move(na);
+                    b = std::move(nb);
+                    if (c != nullptr)
+                    {
+                        c->mul(c1);
+                    }
+                    continue;
+                }
+            }
+        }
+
+        BigInt::lehmerStep(a, b, c);
+    }
+}
+
+BigInt BigInt::gcd(const BigInt &l, const BigInt &r)
+{
+    BigInt a = BigInt(l).abs();
+    BigInt b = BigInt(r).abs();
+    if (BigInt::cmpAbs(a, b) < 0)
+    {
+        std::swap(a, b);
+    }
+    BigInt::gcdReduce(a, b, 0, nullptr);
+    return a;
+}
+
+BigInt BigInt::lcm(const BigInt &l, const BigInt &r)
+{
+    if (l.numeral.size() == 0 || r.numeral.size() == 0)
+    {
+        return BigInt();
+    }
+    BigInt m = (BigInt(l).abs() / BigInt::gcd(l, r)) * r;
+    return m.abs();
+}
+
+BigInt BigInt::gcdext(const BigInt &l, const BigInt &r, BigInt &x, BigInt &y)
+{
+    BigInt a = BigInt(l).abs();
+    BigInt b = BigInt(r).abs();
+    bool swapped = BigInt::cmpAbs(a, b) < 0;
+    if (swapped)
+    {
+        std::swap(a, b);
+    }
+
+    //(|l|, |r|) = m * (g, 0), so g = det * (m11 * |l| - m01 * |r|)
+    Cofactors c;
+    BigInt::gcdReduce(a, b, 0, &c);
+    BigInt u = c.det < 0 ? -c.m[3] : c.m[3];
+    BigInt v = c.det < 0 ? c.m[1] : -c.m[1];
+    if (swapped)
+    {
+        std::swap(u, v);
+    }
+
+    x = l.sign == BigInt::SIGN_NEG ? -std::move(u) : std::move(u);
+    y = r.sign == BigInt::SIGN_NEG ? -std::move(v) : std::move(v);
+    return a;
+}
+
+BigInt BigInt::modinv(const BigInt &l, const BigInt &m)
+{
+    if (m.sign == BigInt::SIGN_NEG || m.numeral.size() == 0)
+    {
+        throw std::invalid_argument("BigInt: modulus must be positive");
+    }
+
+    BigInt x, y;
+    BigInt a = l % m;
+    if (BigInt::gcdext(a, m, x, y) != 1)
+    {
+        throw std::invalid_argument("BigInt: value is not invertible modulo m");
+    }
+    x %= m;
+    if (x.sign == BigInt::SIGN_NEG && x.numeral.size() != 0)
+    {
+        x += m;
+    }
+    return x;
+}
+
+//Bitwise operations on the infinite two's complement forms. A negative value with magnitude x has
+//the digits ~x + 1, produced on the fly with the carry rippling up and 1s past its top digit. The
+//result is converted back the same way when its sign bit is set.
+template <typename Op>
+BigInt &BigInt::bitwise(const BigInt &o, Op op)
+{
+    size_t n = this->numeral.size();
+    size_t m = o.numeral.size();
+    const digit_t sa = this->sign == BigInt::SIGN_NEG ? (digit_t)BigInt::DIGIT_MAX : 0;
+    const digit_t sb = o.sign == BigInt::SIGN_NEG ? (digit_t)BigInt::DIGIT_MAX : 0;
+    const digit_t sr = op(sa, sb);
+
+    //past an operand whose sign digits decide the result (0 for and, 1s for or) only sign digits are
+    //left, otherwise a negative result takes one more digit for the carry of the conversion back
+    size_t length = std::max(n, m) + (sr != 0);
+    if (op(sa, 0) == op(sa, (digit_t)BigInt::DIGIT_MAX))
+    {
+        length = std::min(length, n);
+    }
+    if (op(sb, 0) == op(sb, (digit_t)BigInt::DIGIT_MAX))
+    {
+        length = std::min(length, m);
+    }
+    this->numeral.resize(length);
+
+    //o may be this object, read after the resize
+    digit_t *r = this->numeral.data();
+    const digit_t *b = o.numeral.data();
+    digit_t ca = sa & 1;
+    digit_t cb = sb & 1;
+    digit_t cr = sr & 1;
+    size_t i = 0;
+    for (; i < length && (ca | cb | cr) != 0; i++)
+    {
+        digit_t x = (r[i] ^ sa) + ca;
+        ca &= x == 0;
+        digit_t y = ((i < m ? b[i] : 0) ^ sb) + cb;
+        cb &= y == 0;
+        digit_t z = (op(x, y) ^ sr) + cr;
+        cr &= z == 0;
+        r[i] = z;
+    }
+
+    //once the carries have died out every digit is independent
+    for (; i < std::min(length, m); i++)
+    {
+        r[i] = op(r[i] ^ sa, b[i] ^ sb) ^ sr;
+    }
+    for (; i < length; i++)
+    {
+        r[i] = op(r[i] ^ sa, sb) ^ sr;
+    }
+
+    this->trim();
+    this->sign = sr != 0 && this->numeral.size() != 0 ? BigInt::SIGN_NEG : BigInt::SIGN_POS;
+    return *this;
+}
+
+BigInt &BigInt::operator&=(const BigInt &o)
+{
+    return this->bitwise(o, std::bit_and<digit_t>());
+}
+
+BigInt &BigInt::operator|=(const BigInt &o)
+{
+    return this->bitwise(o, std::bit_or<digit_t>());
+}
+
+BigInt &BigInt::operator^=(const BigInt &o)
+{
+    return this->bitwise(o, std::bit_xor<digit_t>());
+}
+
+size_t BigInt::bit_length() const
+{
+    return bitLength(this->numeral.data(), this->numeral.size());
+}
+
+size_t BigInt::popcount() const
+{
+    size_t c = 0;
+    for (size_t i = 0; i < this->numeral.size(); i++)
+    {
+        c += __builtin_popcountll(this->numeral[i]);
+    }
+    return c;
+}
+
+bool BigInt::test_bit(size_t n) const
+{
+    size_t i = n / BigInt::DIGIT_BIT;
+    bool bit = i < this->numeral.size() && ((this->numeral[i] >> (n % BigInt::DIGIT_BIT)) & 1) != 0;
+    if (this->sign == BigInt::SIGN_POS)
+    {
+        return bit;
+    }
+
+    //~x + 1 keeps the bits of x up to its lowest set bit and inverts the ones above
+    size_t low = 0;
+    while (this->numeral[low] == 0)
+    {
+        low++;
+    }
+    size_t z = low * BigInt::DIGIT_BIT + ntz(this->numeral[low]);
+    return n <= z ? bit : !bit;
+}
+
+BigInt &BigInt::set_bit(size_t n, bool value)
+{
+    if (this->test_bit(n) == value)
+    {
+        return *this;
+    }
+
+    //flipping the bit moves the value by 2^n, which moves a negative magnitude the other way
+    size_t i = n / BigInt::DIGIT_BIT;
+    digit_t d = (digit_t)1 << (n % BigInt::DIGIT_BIT);
+    if (value == (this->sign == BigInt::SIGN_POS))
+    {
+        if (this->numeral.size() <= i)
+        {
+            this->numeral.resize(i + 1);
+        }
+        if (add1(this->numeral.data() + i, this->numeral.size() - i, d) != 0)
+        {
+            this->numeral.push_back(1);
+        }
+    }
+    else
+    {
+        sub1(this->numeral.data() + i, this->numeral.size() - i, d);
+        this->trim();
+        if (this->numeral.size() == 0)
+        {
+            this->sign = BigInt::SIGN_POS;
+        }
+    }
+    return *this;
+}
+
+void BigInt::shiftLeft(BigInt &r, const BigInt &a, size_t bits)
+{
+    size_t n = a.numeral.size();
+    size_t q = bits / BigInt::DIGIT_BIT;
+    unsigned s = bits % BigInt::DIGIT_BIT;
+    size_t length = n + q + (s != 0);
+
+    if (n == 0)
+    {
+        r.numeral.clear();
+        r.sign = BigInt::SIGN_POS;
+        return;
+    }
+    if (&r == &a && length > r.numeral.capacity())
+    {
+        //shift straight into the new storage instead of growing first
+        BigInt tmp;
+        BigInt::shiftLeft(tmp, a, bits);
+        r = std::move(tmp);
+        return;
+    }
+
+    if (&r != &a)
+    {
+        r.numeral.clear();
+    }
+    r.numeral.resize(length);
+
+    //the source digits keep their place in the resized buffer when shifting in place
+    digit_t *d = r.numeral.data();
+    const digit_t *src = a.numeral.data();
+    if (s != 0)
+    {
+        d[n + q] = lshift(d + q, src, n, s);
+    }
+    else
+    {
+        std::copy_backward(src, src + n, d + n + q);
+    }
+    std::fill(d, d + q, 0);
+
+    r.sign = a.sign;
+    r.trim();
+}
+
+void BigInt::shiftRight(BigInt &r, const BigInt &a, size_t bits)
+{
+    size_t n = a.numeral.size();
+    size_t q = bits / BigInt::DIGIT_BIT;
+    unsigned s = bits % BigInt::DIGIT_BIT;
+
+    if (q >= n)
+    {
+        r.numeral.clear();
+        r.sign = BigInt::SIGN_POS;
+        return;
+    }
+
+    size_t length = n - q;
+    if (&r != &a)
+    {
+        r.numeral.clear();
+        r.numeral.resize(length);
+    }
+
+    digit_t *d = r.numeral.data();
+    const digit_t *src = a.numeral.data() + q;
+    if (s != 0)
+    {
+        rshift(d, src, length, s);
+    }
+    else
+    {
+        std::copy(src, src + length, d);
+    }
+    r.numeral.resize(length);
+
+    r.sign = a.sign;
+    r.trim();
+    if (r.numeral.size() == 0)
+    {
+        r.sign = BigInt::SIGN_POS;
+    }
+}
+
+BigInt &BigInt::operator<<=(size_t o)
+{
+    BigInt::shiftLeft(*this, *this, o);
+    return *this;
+}
+
+BigInt &BigInt::operator>>=(size_t o)
+{
+    BigInt::shiftRight(*this, *this, o);
+    return *this;
+}
+
+BigInt &BigInt::operator<<=(const BigInt &o)
+{
+    if (o.numeral.size() == 0)
+    {
+        return *this;
+    }
+
+    //RangeError: Maximum BigInt size exceeded
+    assert(o.numeral.size() < 2);
+
+    //the sign of the count is ignored
+    return *this <<= (size_t)o.numeral[0];
+}
+
+BigInt &BigInt::operator>>=(const BigInt &o)
+{
+    if (o.numeral.size() == 0)
+    {
+        return *this;
+    }
+
+    //RangeError: Minimum BigInt size exceeded
+    assert(o.numeral.size() < 2);
+
+    //the sign of the count is ignored
+    return *this >>= (size_t)o.numeral[0];
+}
+
+BigInt &BigInt::operator++()
+{
+    *this += (ddigit_t)1;
+    return *this;
+}
+BigInt &BigInt::operator--()
+{
+    *this -= (ddigit_t)1;
+    return *this;
+}
+
+const BigInt &BigInt::radixPower(int base, size_t i)
+{
+    //a deque so that references handed out stay valid as the table grows
+    static thread_local std::deque<BigInt> powers[37];
+
+    std::deque<BigInt> &p = powers[base];
+    CacheAllocation scope;
+    while (p.size() <= i)
+    {
+        if (p.empty())
+        {
+            //a full limb, it may not fit the signed scalar constructor
+            digit_t big;
+            charsPerDigit(base, big);
+            BigInt b;
+            b.numeral.push_back(big);
+            p.push_back(std::move(b));
+        }
+        else
+        {
+            p.push_back(p.back() * p.back());
+        }
+    }
+    return p[i];
+}
+
+std::string BigInt::to_string(int base) const
+{
+    if (base < 2 || base > 36)
     {
-        this->numeral.push_back(std::abs(v));
+        throw std::invalid_argument("BigInt: base must be between 2 and 36");
+    }
+    if (this->numeral.size() == 0)
+    {
+        return "0";
     }
-}
-BigInt::BigInt(std::string s, int base)
-{
-    this->sign = BigInt::SIGN_POS;
-    //remove leading zeros
-    s.erase(0, s.find_first_not_of('0'));
 
-    // return type of stoul is unsigned long
-    assert(sizeof(unsigned long) == sizeof(digit_t));
+    //at most DIGIT_BIT / floor(log2(base)) characters per digit, plus the sign
+    size_t bits = 1;
+    while ((2 << bits) <= base)
+    {
+        bits++;
+    }
+    std::string s(this->numeral.size() * BigInt::DIGIT_BIT / bits + 2, '0');
 
-    size_t length = s.size();
-    for (size_t i = 8; i <= length; i += 8)
+    char *end = &s[0] + s.size();
+    char *begin;
+    if ((base & (base - 1)) == 0)
     {
-        std::string v_str = s.substr(length - i, 8);
-        digit_t v = (digit_t)stoul(v_str, 0, base);
-        this->numeral.push_back(v);
+        begin = BigInt::formatPow2(*this, base, end);
     }
-    if (length % 8)
+    else
+    {
+        begin = BigInt::formatDC(*this, base, end, 0);
+    }
+    if (this->sign == BigInt::SIGN_NEG)
     {
-        std::string v_str = s.substr(0, length % 8);
-        digit_t v = (digit_t)stoul(v_str, 0, base);
-        this->numeral.push_back(v);
+        *--begin = '-';
     }
+    s.erase(0, begin - &s[0]);
+    return s;
 }
 
-BigInt::BigInt(std::string s) : BigInt(s, 10)
-{
-}
+static const char digitChars[] = "0123456789abcdefghijklmnopqrstuvwxyz";
 
-BigInt::BigInt(const BigInt &o)
+//power of two bases read the characters straight off the bits of the digits, least significant first
+char *BigInt::formatPow2(const BigInt &o, int base, char *end)
 {
-    this->sign = o.sign;
-    this->numeral = o.numeral;
-}
+    size_t bits = 0;
+    while ((1 << bits) < base)
+    {
+        bits++;
+    }
 
-BigInt::~BigInt()
-{
+    size_t length = o.numeral.size();
+    for (size_t pos = 0; pos < length * BigInt::DIGIT_BIT; pos += bits)
+    {
+        size_t i = pos / BigInt::DIGIT_BIT;
+        size_t shift = pos % BigInt::DIGIT_BIT;
+        digit_t v = o.numeral[i] >> shift;
+        //the character straddles two digits
+        if (shift + bits > BigInt::DIGIT_BIT && i + 1 < length)
+        {
+            v |= o.numeral[i + 1] << (BigInt::DIGIT_BIT - shift);
+        }
+        *--end = digitChars[v & (base - 1)];
+    }
+    //the top digit may leave leading zero characters behind
+    while (*end == '0')
+    {
+        end++;
+    }
+    return end;
 }
 
-ddigit_t BigInt::cmp(const BigInt &l, const BigInt &r)
+//schoolbook conversion, peels k characters at a time off a copy with single digit divisions,
+//writes at least width characters ending at end and returns where they begin
+char *BigInt::formatBase(const BigInt &o, int base, char *end, size_t width)
 {
-    if (l.sign != r.sign)
+    digit_t big;
+    size_t k = charsPerDigit(base, big);
+
+    char *stop = end - width;
+    BigInt tmp(o);
+    while (tmp.numeral.size() != 0)
     {
-        return l.sign;
+        digit_t d = BigInt::digitDiv(tmp, big, tmp);
+        for (size_t j = 0; j < k && (d != 0 || tmp.numeral.size() != 0); j++)
+        {
+            *--end = digitChars[d % base];
+            d /= base;
+        }
     }
-    //Assuming that no leading zero are allowed.
-    if (l.numeral.size() != r.numeral.size())
+    while (end > stop)
     {
-        return (l.sign) * ((ddigit_t)l.numeral.size() - (ddigit_t)r.numeral.size());
+        *--end = '0';
     }
+    return end;
+}
 
-    size_t length = l.numeral.size();
-    for (size_t i = length - 1; i < length; i--)
+//divide and conquer: split by the cached power base^(k * 2^i) closest to the square root,
+//the low part is written zero padded to exactly k * 2^i characters
+char *BigInt::formatDC(const BigInt &o, int base, char *end, size_t width)
+{
+    size_t length = o.numeral.size();
+    if (length <= BigInt::FORMAT_THRESHOLD)
     {
+        return BigInt::formatBase(o, base, end, width);
+    }
 
-        if (l.numeral[i] != r.numeral[i])
-        {
-            return l.sign * ((ddigit_t)l.numeral[i] - (ddigit_t)r.numeral[i]);
-        }
+    digit_t big;
+    size_t k = charsPerDigit(base, big);
+
+    size_t i = 0;
+    while (2 * BigInt::radixPower(base, i + 1).numeral.size() <= length + 1)
+    {
+        i++;
     }
-    //both l and r are equal
-    return 0;
+    size_t low = k << i;
+
+    std::pair<BigInt, BigInt> qr = BigInt::divmod(o, BigInt::radixPower(base, i));
+    qr.first.sign = BigInt::SIGN_POS;
+    qr.second.sign = BigInt::SIGN_POS;
+    end = BigInt::formatDC(qr.second, base, end, low);
+    return BigInt::formatDC(qr.first, base, end, width > low ? width - low : 0);
 }
 
-BigInt BigInt::complement(const BigInt &o)
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+static const Endian hostEndian = Endian::little;
+#else
+static const Endian hostEndian = Endian::big;
+#endif
+
+static inline uint32_t byteSwap(uint32_t x)
 {
-    return ((BigInt(1) << (o.numeral.size() * BigInt::DIGIT_BIT)) + o);
+    return __builtin_bswap32(x);
 }
 
-inline std::pair<digit_t, digit_t> BigInt::add(digit_t a, digit_t b, digit_t d)
+static inline uint64_t byteSwap(uint64_t x)
 {
-    uddigit_t s = ((uddigit_t)a + b) + d;
-    return std::make_pair(s & BigInt::DIGIT_MAX, s > BigInt::DIGIT_MAX);
+    return __builtin_bswap64(x);
 }
-inline std::pair<digit_t, digit_t> BigInt::sub(digit_t a, digit_t b, digit_t d)
+
+//memory offset of byte k, counted from the least significant, of count words of word bytes
+static inline size_t byteOffset(size_t k, size_t count, size_t word, Endian order, Endian endian)
 {
-    ddigit_t s = ((ddigit_t)a - b) - d;
-    return std::make_pair(s >= 0 ? s : ((BigInt::DIGIT_MAX + 1) << 1) + s, s < 0);
+    size_t w = k / word;
+    size_t b = k % word;
+    return (order == Endian::little ? w : count - 1 - w) * word + (endian == Endian::little ? b : word - 1 - b);
 }
 
-BigInt &BigInt::operator+=(const BigInt &o)
+BigInt BigInt::import_bytes(const void *data, size_t count, size_t word, Endian order, Endian endian)
 {
+    const size_t D = sizeof(digit_t);
+    const unsigned char *p = static_cast<const unsigned char *>(data);
+    order = order == Endian::native ? hostEndian : order;
+    endian = endian == Endian::native ? hostEndian : endian;
 
-    if (this->sign != o.sign)
-    {
-        BigInt tmp(o);
-        tmp.sign = -tmp.sign;
-        return operator-=(tmp);
-    }
-
-    size_t n = std::min(this->numeral.size(), o.numeral.size());
-    size_t m = std::max(this->numeral.size(), o.numeral.size());
-
-    //std::vector<digit_t> sum(m, 0);
+    size_t total = count * word;
+    BigInt r;
+    r.numeral.resize((total + D - 1) / D);
+    digit_t *d = r.numeral.data();
 
-    digit_t c = 0; //carry
-
-    for (size_t i = 0; i < n; i++)
-    {
-        std::tie(this->numeral[i], c) = BigInt::add(this->numeral[i], o.numeral[i], c);
-    }
-
-    if (this->numeral.size() > n)
-    {
-        for (size_t i = n; i < m && c; i++)
-        {
-            std::tie(this->numeral[i], c) = BigInt::add(this->numeral[i], 0, c);
-        }
-    }
-    else
+    //a single run of bytes in either direction moves whole digits at a time on little endian hosts
+    bool little = (order == Endian::little || count == 1) && (endian == Endian::little || word == 1);
+    bool big = (order == Endian::big || count == 1) && (endian == Endian::big || word == 1);
+    size_t k = 0;
+    if (hostEndian == Endian::little && (little || big))
     {
-        for (size_t i = n; i < m; i++)
+        for (; k + D <= total; k += D)
         {
-            digit_t sum;
-            std::tie(sum, c) = BigInt::add(0, o.numeral[i], c);
-            this->numeral.push_back(sum);
+            digit_t x;
+            if (little)
+            {
+                std::copy(p + k, p + k + D, reinterpret_cast<unsigned char *>(&x));
+            }
+            else
+            {
+                std::copy(p + total - k - D, p + total - k, reinterpret_cast<unsigned char *>(&x));
+                x = byteSwap(x);
+            }
+            d[k / D] = x;
         }
     }
-
-    if (c != 0)
+    for (; k < total; k++)
     {
-        this->numeral.push_back(c);
+        d[k / D] |= (digit_t)p[byteOffset(k, count, word, order, endian)] << (k % D * CHAR_BIT);
     }
-
-    return *this;
+    r.trim();
+    return r;
 }
 
-BigInt &BigInt::operator-=(const BigInt &o)
+BigInt BigInt::deserialize(const void *in, size_t size, size_t *used)
 {
-    if (this->sign != o.sign)
+    const unsigned char *p = static_cast<const unsigned char *>(in);
+    if (size < 8)
     {
-        BigInt tmp(o);
-        tmp.sign = -tmp.sign;
-        return operator+=(tmp);
+        throw std::invalid_argument("BigInt: truncated serialized value");
     }
-
-    //compare absolute values
-    ddigit_t d = this->sign * BigInt::cmp(*this, o);
-    if (d < 0)
+    uint64_t h = 0;
+    for (size_t i = 0; i < 8; i++)
     {
-
-        this->numeral = std::move((o - *this).numeral);
-        this->sign = -this->sign;
-        return *this;
+        h |= (uint64_t)p[i] << (i * CHAR_BIT);
     }
-    else if (d == 0)
+    uint64_t words = h >> 1;
+    if (words > (size - 8) / 8)
     {
-        this->numeral.clear();
-        return *this;
+        throw std::invalid_argument("BigInt: truncated serialized value");
     }
 
-    size_t n = o.numeral.size();     //min
-    size_t m = this->numeral.size(); //max
-
-    digit_t b = 0; //borrow
-    for (size_t i = 0; i < n; i++)
+    BigInt r = BigInt::import_bytes(p + 8, words, 8, Endian::little, Endian::little);
+    if ((h & 1) != 0 && r.numeral.size() != 0)
     {
-        std::tie(this->numeral[i], b) = BigInt::sub(this->numeral[i], o.numeral[i], b);
+        r.sign = BigInt::SIGN_NEG;
     }
-    for (size_t i = n; i < m && b; i++)
+    if (used != nullptr)
     {
-        std::tie(this->numeral[i], b) = BigInt::sub(this->numeral[i], 0, b);
+        *used = 8 + words * 8;
     }
+    return r;
+}
 
-    this->trim();
-
-    return *this;
+size_t BigInt::export_size(size_t word) const
+{
+    return BigIntView(*this).export_size(word);
 }
-BigInt BigInt::baseMul(const BigInt &l, const BigInt &r)
+
+size_t BigInt::export_bytes(void *data, size_t count, size_t word, Endian order, Endian endian) const
 {
-    size_t lsize = l.numeral.size();
-    size_t rsize = r.numeral.size();
+    return BigIntView(*this).export_bytes(data, count, word, order, endian);
+}
 
-    BigInt mul;
-    mul.numeral = std::vector<digit_t>(lsize + rsize, 0);
+size_t BigInt::serialized_size() const
+{
+    return BigIntView(*this).serialized_size();
+}
 
-    for (size_t i = 0; i < lsize; i++)
-    {
-        uddigit_t carry = 0;
-        for (size_t j = 0; j < rsize; j++)
-        {
-            uddigit_t sum = (uddigit_t)l.numeral[i] * r.numeral[j] + (mul.numeral[i + j] + carry);
-            mul.numeral[i + j] = sum & BigInt::DIGIT_MAX;
-            carry = (sum >> BigInt::DIGIT_BIT);
-        }
-        if (carry != 0)
-        {
-            mul.numeral[i + r.numeral.size()] = carry;
-        }
-    }
-    mul.sign = l.sign * r.sign;
+size_t BigInt::serialize(void *out, size_t size) const
+{
+    return BigIntView(*this).serialize(out, size);
+}
 
-    while (mul.numeral.back() == 0)
+BigIntView::BigIntView(const digit_t *d, size_t n, bool negative)
+{
+    while (n != 0 && d[n - 1] == 0)
     {
-        mul.numeral.pop_back();
+        n--;
     }
-    return mul;
-}
-BigInt &BigInt::baseMul(const BigInt &o)
-{
-    this->numeral = std::move(BigInt::baseMul(*this, o).numeral);
-    return *this;
+    this->d = d;
+    this->n = n;
+    this->neg = negative && n != 0;
 }
 
-BigInt BigInt::karatsubaMul(BigInt &l, BigInt &r)
+BigIntView BigIntView::deserialize(const void *in, size_t size, size_t *used)
 {
-    size_t n = l.numeral.size();
-    size_t m = r.numeral.size();
-
-    if (n == 0 || m == 0)
+    const unsigned char *p = static_cast<const unsigned char *>(in);
+    if (hostEndian != Endian::little)
     {
-        return 0;
+        throw std::invalid_argument("BigIntView: serialized values are read in place on little endian hosts only");
     }
-    if ((n + m) < (2 * BigInt::KARATSUBA_THRESHOLD))
+    if (reinterpret_cast<uintptr_t>(p + 8) % alignof(digit_t) != 0)
     {
-        return BigInt::baseMul(l, r);
+        throw std::invalid_argument("BigIntView: serialized value is not aligned for digit_t");
     }
-
-    if (n < m)
+    if (size < 8)
     {
-        l.pad(m - n);
-        n = m;
+        throw std::invalid_argument("BigIntView: truncated serialized value");
     }
-    else
+    uint64_t h;
+    std::copy(p, p + 8, reinterpret_cast<unsigned char *>(&h));
+    uint64_t words = h >> 1;
+    if (words > (size - 8) / 8)
     {
-        r.pad(n - m);
-        m = n;
+        throw std::invalid_argument("BigIntView: truncated serialized value");
     }
-
-    if ((n % 2) == 1)
+    if (used != nullptr)
     {
-        l.numeral.push_back(0);
-        r.numeral.push_back(0);
-        n++;
+        *used = 8 + words * 8;
     }
-
-    size_t k = n / 2;
-
-    BigInt l0, l1, l2;
-    BigInt r0, r1, r2;
-
-    l0.numeral.assign(l.numeral.begin() + 0, l.numeral.begin() + k);
-    l1.numeral.assign(l.numeral.begin() + k, l.numeral.begin() + n);
-
-    r0.numeral.assign(r.numeral.begin() + 0, r.numeral.begin() + k);
-    r1.numeral.assign(r.numeral.begin() + k, r.numeral.begin() + n);
-
-    l2 = l0 - l1;
-    r2 = r0 - r1;
-
-    int sign = -(l2.sign * r2.sign);
-
-    BigInt c0 = BigInt::karatsubaMul(l0, r0);
-    BigInt c1 = BigInt::karatsubaMul(l1, r1);
-    BigInt c2 = BigInt::karatsubaMul(l2.abs(), r2.abs());
-
-    c2.sign = sign;
-
-    BigInt c;
-    c += c0;
-    c += (c0 + c1 + c2) << (k * BigInt::DIGIT_BIT);
-    c += c1 << (2 * k * BigInt::DIGIT_BIT);
-    return c;
+    return BigIntView(reinterpret_cast<const digit_t *>(p + 8), words * 8 / sizeof(digit_t), (h & 1) != 0);
 }
 
-BigInt &BigInt::karatsubaMul(const BigInt &o)
+size_t BigIntView::bit_length() const
 {
-    BigInt r(o);
-    this->numeral = std::move(BigInt::karatsubaMul(*this, r).numeral);
-    return *this;
+    return bitLength(this->d, this->n);
 }
 
-BigInt &BigInt::operator*=(const BigInt &o)
+size_t BigIntView::export_size(size_t word) const
 {
-    return this->karatsubaMul(o);
+    return ((this->bit_length() + CHAR_BIT - 1) / CHAR_BIT + word - 1) / word;
 }
 
-BigInt &BigInt::operator/=(const BigInt &o) { return *this; }
-BigInt &BigInt::operator%=(const BigInt &o) { return *this; }
-
-BigInt &BigInt::operator&=(const BigInt &o)
+size_t BigIntView::export_bytes(void *data, size_t count, size_t word, Endian order, Endian endian) const
 {
+    const size_t D = sizeof(digit_t);
+    unsigned char *p = static_cast<unsigned char *>(data);
+    order = order == Endian::native ? hostEndian : order;
+    endian = endian == Endian::native ? hostEndian : endian;
 
-    BigInt l = BigInt(*this);
-    BigInt r = BigInt(o);
-    if (l.sign == BigInt::SIGN_NEG)
+    size_t words = this->export_size(word);
+    if (words > count)
     {
-        l.numeral = std::move((BigInt::complement(l).numeral));
+        throw std::invalid_argument("BigInt: magnitude does not fit the export buffer");
     }
-    if (r.sign == BigInt::SIGN_NEG)
+
+    size_t total = count * word;
+    bool little = (order == Endian::little || count == 1) && (endian == Endian::little || word == 1);
+    bool big = (order == Endian::big || count == 1) && (endian == Endian::big || word == 1);
+    size_t k = 0;
+    if (hostEndian == Endian::little && (little || big))
     {
-        r.numeral = std::move((BigInt::complement(r).numeral));
+        for (; k + D <= total; k += D)
+        {
+            digit_t x = k / D < this->n ? this->d[k / D] : 0;
+            if (little)
+            {
+                const unsigned char *b = reinterpret_cast<const unsigned char *>(&x);
+                std::copy(b, b + D, p + k);
+            }
+            else
+            {
+                x = byteSwap(x);
+                const unsigned char *b = reinterpret_cast<const unsigned char *>(&x);
+                std::copy(b, b + D, p + total - k - D);
+            }
+        }
     }
-
-    size_t n = std::min(l.numeral.size(), r.numeral.size());
-    for (size_t i = 0; i < n; i++)
+    for (; k < total; k++)
     {
-        l.numeral[i] &= r.numeral[i];
+        digit_t x = k / D < this->n ? this->d[k / D] : 0;
+        p[byteOffset(k, count, word, order, endian)] = (unsigned char)(x >> (k % D * CHAR_BIT));
     }
-    if (this->sign == BigInt::SIGN_NEG && o.sign == BigInt::SIGN_NEG)
+    return words;
+}
+
+size_t BigIntView::serialized_size() const
+{
+    return 8 + this->export_size(8) * 8;
+}
+
+size_t BigIntView::serialize(void *out, size_t size) const
+{
+    unsigned char *p = static_cast<unsigned char *>(out);
+    size_t words = this->export_size(8);
+    if (size < 8 + words * 8)
     {
-        l.sign = BigInt::SIGN_NEG;
-        this->sign = BigInt::SIGN_NEG;
-        this->numeral = std::move((BigInt::complement(l).numeral));
+        throw std::invalid_argument("BigInt: serialization buffer is too small");
     }
-    else
+    uint64_t h = ((uint64_t)words << 1) | (this->neg ? 1 : 0);
+    for (size_t i = 0; i < 8; i++)
     {
-        this->numeral = std::move(l.numeral);
-        this->sign = BigInt::SIGN_POS;
+        p[i] = (unsigned char)(h >> (i * CHAR_BIT));
     }
-    this->numeral.erase(this->numeral.cbegin() + n, this->numeral.cend());
-    return *this;
+    this->export_bytes(p + 8, words, 8, Endian::little, Endian::little);
+    return 8 + words * 8;
 }
 
-BigInt &BigInt::operator|=(const BigInt &o)
+int BigIntView::cmp(const BigIntView &l, const BigIntView &r)
 {
-    BigInt l = BigInt(*this);
-    BigInt r = BigInt(o);
-    if (l.sign == BigInt::SIGN_NEG)
+    if (l.neg != r.neg)
     {
-        l.numeral = std::move((BigInt::complement(l).numeral));
+        return l.neg ? -1 : 1;
     }
-    if (r.sign == BigInt::SIGN_NEG)
+    int s = l.neg ? -1 : 1;
+    if (l.n != r.n)
+    {
+        return l.n < r.n ? -s : s;
+    }
+    for (size_t i = l.n - 1; i < l.n; i--)
     {
-        r.numeral = std::move((BigInt::complement(r).numeral));
+        if (l.d[i] != r.d[i])
+        {
+            return l.d[i] < r.d[i] ? -s : s;
+        }
     }
+    return 0;
+}
 
-    size_t n = std::min(l.numeral.size(), r.numeral.size());
+#ifdef BIGINT_MMAP
+static std::runtime_error mappingError(const std::string &what, const std::string &path)
+{
+    return std::runtime_error("MappedBigInt: " + what + " " + path + ": " + std::strerror(errno));
+}
 
-    for (size_t i = 0; i < n; i++)
+MappedBigInt::MappedBigInt(const std::string &path)
+{
+    if (hostEndian != Endian::little)
     {
-        l.numeral[i] |= r.numeral[i];
+        throw std::runtime_error("MappedBigInt: little endian hosts only");
     }
-
-    if (l.numeral.size() < r.numeral.size())
+    this->fd = ::open(path.c_str(), O_RDONLY);
+    if (this->fd < 0)
     {
-        for (size_t i = n; i < r.numeral.size(); i++)
-        {
-            l.numeral.push_back(r.numeral[i]);
-        }
+        throw mappingError("cannot open", path);
     }
-    //FIXME:
-    if (this->sign == BigInt::SIGN_NEG || o.sign == BigInt::SIGN_NEG)
+    struct stat st;
+    if (fstat(this->fd, &st) != 0 || st.st_size < 8)
     {
-        l.sign = BigInt::SIGN_NEG;
-        this->sign = BigInt::SIGN_NEG;
-        this->numeral = std::move((BigInt::complement(l).numeral));
+        ::close(this->fd);
+        throw std::runtime_error("MappedBigInt: not a serialized value " + path);
     }
-    else
+    this->length = st.st_size;
+    void *p = mmap(nullptr, this->length, PROT_READ, MAP_SHARED, this->fd, 0);
+    if (p == MAP_FAILED)
     {
-        this->numeral = std::move(l.numeral);
-        this->sign = BigInt::SIGN_POS;
+        ::close(this->fd);
+        throw mappingError("cannot map", path);
     }
+    this->base = static_cast<unsigned char *>(p);
+    madvise(p, this->length, MADV_SEQUENTIAL);
+}
 
-    this->numeral.erase(this->numeral.cbegin() + n, this->numeral.cend());
-
-    return *this;
+//a zero value with room for digits limbs, the file is sparse until written
+MappedBigInt::MappedBigInt(const std::string &path, size_t digits)
+{
+    if (hostEndian != Endian::little)
+    {
+        throw std::runtime_error("MappedBigInt: little endian hosts only");
+    }
+    this->fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (this->fd < 0)
+    {
+        throw mappingError("cannot create", path);
+    }
+    size_t words = (digits * sizeof(digit_t) + 7) / 8;
+    this->length = 8 + words * 8;
+    if (ftruncate(this->fd, this->length) != 0)
+    {
+        ::close(this->fd);
+        throw mappingError("cannot size", path);
+    }
+    void *p = mmap(nullptr, this->length, PROT_READ | PROT_WRITE, MAP_SHARED, this->fd, 0);
+    if (p == MAP_FAILED)
+    {
+        ::close(this->fd);
+        throw mappingError("cannot map", path);
+    }
+    this->base = static_cast<unsigned char *>(p);
+    madvise(p, this->length, MADV_SEQUENTIAL);
 }
-BigInt &BigInt::operator^=(const BigInt &o)
+
+MappedBigInt::MappedBigInt(MappedBigInt &&o) noexcept : fd(o.fd), base(o.base), length(o.length)
 {
-    //FIXME::
-    size_t n = std::min(this->numeral.size(), o.numeral.size());
+    o.fd = -1;
+    o.base = nullptr;
+    o.length = 0;
+}
 
-    for (size_t i = 0; i < n; i++)
+MappedBigInt &MappedBigInt::operator=(MappedBigInt &&o) noexcept
+{
+    if (this != &o)
     {
-        this->numeral[i] ^= o.numeral[i];
+        std::swap(this->fd, o.fd);
+        std::swap(this->base, o.base);
+        std::swap(this->length, o.length);
     }
-    this->numeral.erase(this->numeral.cbegin() + n, this->numeral.cend());
     return *this;
 }
 
-BigInt &BigInt::operator<<=(const BigInt &o)
+MappedBigInt::~MappedBigInt()
 {
-    if (o.sign == BigInt::SIGN_NEG)
+    if (this->base != nullptr)
     {
-        BigInt tmp(o);
-        tmp.sign = -tmp.sign;
-        return this->operator<<=(tmp);
+        munmap(this->base, this->length);
     }
-
-    if (*this == 0 || o == 0)
+    if (this->fd >= 0)
     {
-        return *this;
+        ::close(this->fd);
     }
+}
 
-    //RangeError: Maximum BigInt size exceeded
-    assert(o.numeral.size() < 2);
+//the header covers every word of the file, the leading zero ones are dropped when it is read
+void MappedBigInt::finish(bool negative)
+{
+    uint64_t h = ((uint64_t)(this->length / 8 - 1) << 1) | (negative ? 1 : 0);
+    std::copy(reinterpret_cast<const unsigned char *>(&h), reinterpret_cast<const unsigned char *>(&h) + 8, this->base);
+}
+
+BigIntView MappedBigInt::view() const
+{
+    return BigIntView::deserialize(this->base, this->length);
+}
+
+MappedBigInt MappedBigInt::store(const std::string &path, const BigIntView &v)
+{
+    MappedBigInt r(path, v.size());
+    std::copy(v.data(), v.data() + v.size(), r.digits());
+    r.finish(v.negative());
+    return r;
+}
 
-    digit_t lshift;
+MappedBigInt MappedBigInt::add(const std::string &path, const BigIntView &a, const BigIntView &b)
+{
+    const BigIntView *x = &a;
+    const BigIntView *y = &b;
+    bool same = a.negative() == b.negative();
 
-    lshift = (o.numeral[0] & ~(BigInt::DIGIT_BIT - 1));
-    if (lshift != 0)
+    //magnitudes, the larger one first when they are subtracted
+    if (!same && BigIntView::cmp(BigIntView(a.data(), a.size()), BigIntView(b.data(), b.size())) < 0)
     {
-        this->numeral.insert(this->numeral.begin(), (lshift / BigInt::DIGIT_BIT), 0);
+        std::swap(x, y);
     }
-
-    lshift = (o.numeral[0] & (BigInt::DIGIT_BIT - 1));
-
-    if (lshift != 0)
+    else if (same && a.size() < b.size())
     {
+        std::swap(x, y);
+    }
+    size_t n = x->size();
+    size_t m = y->size();
 
-        size_t length = this->numeral.size();
-
-        digit_t msb = this->numeral[length - 1] >> (BigInt::DIGIT_BIT - lshift); // most significant bits
-        for (size_t i = length - 1; i ; i--)
+    MappedBigInt r(path, same ? n + 1 : n);
+    digit_t *d = r.digits();
+    const digit_t *u = x->data();
+    const digit_t *v = y->data();
+    const size_t tile = MappedBigInt::ADD_TILE;
+    digit_t c = 0; //carry or borrow between tiles
+    for (size_t i = 0; i < n; i += tile)
+    {
+        size_t len = std::min(tile, n - i);
+        size_t k = i < m ? std::min(len, m - i) : 0;
+        std::copy(u + i + k, u + i + len, d + i + k);
+        if (same)
         {
-            this->numeral[i] = this->numeral[i] << lshift;
-            this->numeral[i] |= this->numeral[i - 1] >> (BigInt::DIGIT_BIT - lshift);
+            digit_t t = add1(d + i + k, len - k, addN(d + i, u + i, v + i, k));
+            c = t + add1(d + i, len, c);
         }
-        this->numeral[0] <<= lshift;
-        if (msb != 0)
+        else
         {
-            this->numeral.push_back(msb);
+            digit_t t = sub1(d + i + k, len - k, subN(d + i, u + i, v + i, k));
+            c = t + sub1(d + i, len, c);
         }
     }
+    if (same)
+    {
+        d[n] = c;
+    }
+    r.finish(x->negative());
+    return r;
+}
 
-    return *this;
+MappedBigInt MappedBigInt::sub(const std::string &path, const BigIntView &a, const BigIntView &b)
+{
+    return MappedBigInt::add(path, a, BigIntView(b.data(), b.size(), !b.negative()));
 }
 
-BigInt &BigInt::operator>>=(const BigInt &o)
+MappedBigInt MappedBigInt::mul(const std::string &path, const BigIntView &a, const BigIntView &b, size_t tile)
 {
-    if (o.sign == BigInt::SIGN_NEG)
-    {
-        BigInt tmp(o);
-        tmp.sign = -tmp.sign;
-        return this->operator>>=(tmp);
-    }
+    //RangeError: Invalid tile size
+    assert(tile != 0);
 
-    if (*this == 0 || o == 0)
+    size_t n = a.size();
+    size_t m = b.size();
+    MappedBigInt r(path, n + m);
+    digit_t *d = r.digits();
+    if (n == 0 || m == 0)
     {
-        return *this;
+        r.finish(false);
+        return r;
     }
 
-    //RangeError: Minimum BigInt size exceeded
-    assert(o.numeral.size() < 2);
-
-    digit_t rshift;
-    rshift = (o.numeral[0] & ~(BigInt::DIGIT_BIT - 1));
-    if (rshift != 0)
+    size_t ta = (n + tile - 1) / tile;
+    size_t tb = (m + tile - 1) / tile;
+    BigInt acc; //the part of the columns so far above the tiles already written
+    for (size_t k = 0; k < ta + tb - 1; k++)
     {
-        if ((rshift / BigInt::DIGIT_BIT) >= this->numeral.size())
+        for (size_t i = k < tb ? 0 : k - tb + 1; i <= k && i < ta; i++)
         {
-            this->numeral.clear();
-            return *this;
+            size_t j = k - i;
+            BigInt x(BigIntView(a.data() + i * tile, std::min(tile, n - i * tile)));
+            BigInt y(BigIntView(b.data() + j * tile, std::min(tile, m - j * tile)));
+            acc.addmul(x, y);
         }
-        this->numeral.erase(this->numeral.begin(), this->numeral.begin() + (rshift / BigInt::DIGIT_BIT));
+        size_t len = std::min(acc.numeral.size(), tile);
+        std::copy(acc.numeral.begin(), acc.numeral.begin() + len, d + k * tile);
+        acc = BigInt::slice(acc, tile, acc.numeral.size());
     }
+    std::copy(acc.numeral.begin(), acc.numeral.end(), d + (ta + tb - 1) * tile);
+    r.finish(a.negative() != b.negative());
+    return r;
+}
+#else
+MappedBigInt::MappedBigInt(const std::string &path) : fd(-1), base(nullptr), length(0)
+{
+    throw std::runtime_error("MappedBigInt: memory mapped files are not supported on this platform " + path);
+}
 
-    rshift = (o.numeral[0] & (BigInt::DIGIT_BIT - 1));
+MappedBigInt::MappedBigInt(const std::string &path, size_t) : MappedBigInt(path)
+{
+}
 
-    if (rshift != 0)
-    {
-        size_t length = this->numeral.size();
-        for (size_t i = 0; i < length - 1; i++)
-        {
-            this->numeral[i] = this->numeral[i] >> rshift;
-            this->numeral[i] |= this->numeral[i + 1] << (BigInt::DIGIT_BIT - rshift);
-        }
+MappedBigInt::MappedBigInt(MappedBigInt &&o) noexcept : fd(o.fd), base(o.base), length(o.length)
+{
+}
 
-        this->numeral[length - 1] >>= rshift;
-        this->trim();
-    }
+MappedBigInt &MappedBigInt::operator=(MappedBigInt &&) noexcept
+{
     return *this;
 }
 
-BigInt &BigInt::operator++()
+MappedBigInt::~MappedBigInt()
 {
-    *this += BigInt(1);
-    return *this;
 }
-BigInt &BigInt::operator--()
+
+void MappedBigInt::finish(bool)
 {
-    *this -= BigInt(1);
-    return *this;
 }
 
-std::ostream &operator<<(std::ostream &os, const BigInt &a)
+BigIntView MappedBigInt::view() const
+{
+    return BigIntView();
+}
+
+MappedBigInt MappedBigInt::store(const std::string &path, const BigIntView &)
 {
+    return MappedBigInt(path, 0);
+}
+
+MappedBigInt MappedBigInt::add(const std::string &path, const BigIntView &, const BigIntView &)
+{
+    return MappedBigInt(path, 0);
+}
+
+MappedBigInt MappedBigInt::sub(const std::string &path, const BigIntView &, const BigIntView &)
+{
+    return MappedBigInt(path, 0);
+}
+
+MappedBigInt MappedBigInt::mul(const std::string &path, const BigIntView &, const BigIntView &, size_t)
+{
+    return MappedBigInt(path, 0);
+}
+#endif
 
-    size_t length = a.numeral.size();
-    if (length != 0)
+std::ostream &operator<<(std::ostream &os, const BigInt &a)
+{
+    std::ios_base::fmtflags basefield = os.flags() & std::ios_base::basefield;
+    if (basefield == std::ios_base::hex)
     {
+        //hex streams print JavaScript BigInt literals, as consumed by the test harness
+        std::string s = a.to_string(16);
         if (a.sign == BigInt::SIGN_NEG)
         {
-            os << '-';
+            s.insert(1, "0x");
         }
-
-        os << "0x";
-
-        os << std::hex << a.numeral[length - 1];
-        for (size_t i = length - 2; i < length; i--)
+        else
         {
-            auto digit = a.numeral[i];
-            os << std::setw(8) << std::setfill('0') << digit;
-            //os << digit;
+            s.insert(0, "0x");
         }
-        //os << '[' << std::dec << length << ']';
-        os << 'n';
+        s.push_back('n');
+        os << s;
+    }
+    else if (basefield == std::ios_base::oct)
+    {
+        os << a.to_string(8);
     }
     else
     {
-        os << '0';
+        os << a.to_string(10);
     }
 
     return os;
@@ -1,17 +1,270 @@
 #include <iostream>
-#include <vector>
+#include <string>
+#include <utility>
+#include <algorithm>
+#include <new>
 #include <cstdint>
 #include <cstddef>
 #include <climits>
+#include <functional>
+#include <type_traits>
 
 namespace bigint
 {
 
-typedef uint32_t digit_t;
+//limb width in bits, 64 needs a compiler with unsigned __int128 for the double width products
+#ifndef BIGINT_DIGIT_BIT
+#ifdef __SIZEOF_INT128__
+#define BIGINT_DIGIT_BIT 64
+#else
+#define BIGINT_DIGIT_BIT 32
+#endif
+#endif
 
+#if BIGINT_DIGIT_BIT == 64
+typedef uint64_t digit_t;
+__extension__ typedef unsigned __int128 uddigit_t;
+#elif BIGINT_DIGIT_BIT == 32
+typedef uint32_t digit_t;
 typedef uint64_t uddigit_t;
+#else
+#error "BIGINT_DIGIT_BIT must be 32 or 64"
+#endif
+
+//scalar operand type of the public interface, independent of the limb width
 typedef int64_t ddigit_t;
 
+//Source of the heap storage of BigInt digits, see BigInt::setAllocator
+class LimbAllocator
+{
+  public:
+    virtual void *allocate(size_t bytes) = 0;
+    virtual void deallocate(void *p, size_t bytes) = 0;
+    virtual ~LimbAllocator() {}
+};
+
+//the allocator of the calling thread, nullptr for operator new
+LimbAllocator *limbAllocator();
+
+//Contiguous container with room for N elements inside the object itself, it only goes to the heap once it grows
+//past that. Implements the subset of the std::vector interface used by BigInt, T must be trivially copyable.
+template <typename T, size_t N>
+class SmallVector
+{
+  private:
+    T *ptr;
+    size_t length;
+    size_t cap;
+    T buffer[N];
+
+    static_assert(sizeof(T) * N >= sizeof(LimbAllocator *), "SmallVector: no room for the allocator");
+
+    inline bool local() const { return this->ptr == this->buffer; }
+
+    //heap storage remembers its allocator in the then unused inline buffer
+    inline LimbAllocator *owner() const
+    {
+        LimbAllocator *a;
+        const unsigned char *b = reinterpret_cast<const unsigned char *>(this->buffer);
+        std::copy(b, b + sizeof(a), reinterpret_cast<unsigned char *>(&a));
+        return a;
+    }
+    inline void setOwner(LimbAllocator *a)
+    {
+        const unsigned char *b = reinterpret_cast<const unsigned char *>(&a);
+        std::copy(b, b + sizeof(a), reinterpret_cast<unsigned char *>(this->buffer));
+    }
+    inline void release()
+    {
+        if (!this->local())
+        {
+            LimbAllocator *a = this->owner();
+            if (a != nullptr)
+            {
+                a->deallocate(this->ptr, this->cap * sizeof(T));
+            }
+            else
+            {
+                ::operator delete(this->ptr);
+            }
+        }
+    }
+
+    void grow(size_t n)
+    {
+        size_t c = std::max(n, 2 * this->cap);
+        LimbAllocator *a = limbAllocator();
+        T *p = static_cast<T *>(a != nullptr ? a->allocate(c * sizeof(T)) : ::operator new(c * sizeof(T)));
+        std::copy(this->ptr, this->ptr + this->length, p);
+        this->release();
+        this->ptr = p;
+        this->cap = c;
+        this->setOwner(a);
+    }
+
+  public:
+    typedef T value_type;
+    typedef T *iterator;
+    typedef const T *const_iterator;
+
+    SmallVector() : ptr(buffer), length(0), cap(N) {}
+    SmallVector(size_t n, const T &v) : SmallVector()
+    {
+        this->assign(n, v);
+    }
+    SmallVector(const SmallVector &o) : SmallVector()
+    {
+        this->assign(o.begin(), o.end());
+    }
+    SmallVector(SmallVector &&o) noexcept : SmallVector()
+    {
+        *this = std::move(o);
+    }
+    ~SmallVector()
+    {
+        this->release();
+    }
+
+    SmallVector &operator=(const SmallVector &o)
+    {
+        if (this != &o)
+        {
+            this->assign(o.begin(), o.end());
+        }
+        return *this;
+    }
+    SmallVector &operator=(SmallVector &&o) noexcept
+    {
+        if (this == &o)
+        {
+            return *this;
+        }
+        if (o.local())
+        {
+            //inline elements have to be copied, they always fit in our storage
+            std::copy(o.begin(), o.end(), this->ptr);
+            this->length = o.length;
+        }
+        else
+        {
+            this->release();
+            this->ptr = o.ptr;
+            this->length = o.length;
+            this->cap = o.cap;
+            this->setOwner(o.owner());
+            o.ptr = o.buffer;
+            o.cap = N;
+        }
+        o.length = 0;
+        return *this;
+    }
+
+    inline size_t size() const { return this->length; }
+    inline size_t capacity() const { return this->cap; }
+    inline bool empty() const { return this->length == 0; }
+
+    inline T *data() { return this->ptr; }
+    inline const T *data() const { return this->ptr; }
+
+    inline T &operator[](size_t i) { return this->ptr[i]; }
+    inline const T &operator[](size_t i) const { return this->ptr[i]; }
+    inline T &back() { return this->ptr[this->length - 1]; }
+    inline const T &back() const { return this->ptr[this->length - 1]; }
+
+    inline iterator begin() { return this->ptr; }
+    inline iterator end() { return this->ptr + this->length; }
+    inline const_iterator begin() const { return this->ptr; }
+    inline const_iterator end() const { return this->ptr + this->length; }
+    inline const_iterator cbegin() const { return this->ptr; }
+    inline const_iterator cend() const { return this->ptr + this->length; }
+
+    inline void reserve(size_t n)
+    {
+        if (n > this->cap)
+        {
+            this->grow(n);
+        }
+    }
+    inline void resize(size_t n, const T &v = T())
+    {
+        this->reserve(n);
+        if (n > this->length)
+        {
+            std::fill(this->ptr + this->length, this->ptr + n, v);
+        }
+        this->length = n;
+    }
+    //like resize, but the new elements are left for the caller to write
+    inline void resize_uninitialized(size_t n)
+    {
+        this->reserve(n);
+        this->length = n;
+    }
+    inline void clear() { this->length = 0; }
+
+    inline void push_back(const T &v)
+    {
+        if (this->length == this->cap)
+        {
+            T tmp = v; //v may live in the storage about to be released
+            this->grow(this->length + 1);
+            this->ptr[this->length++] = tmp;
+            return;
+        }
+        this->ptr[this->length++] = v;
+    }
+    inline void pop_back() { this->length--; }
+
+    inline void assign(size_t n, const T &v)
+    {
+        this->clear();
+        this->resize(n, v);
+    }
+    inline void assign(const T *first, const T *last)
+    {
+        size_t n = last - first;
+        if (n > this->cap)
+        {
+            //nothing worth preserving, drop the old storage before allocating
+            this->clear();
+            this->grow(n);
+        }
+        std::copy(first, last, this->ptr);
+        this->length = n;
+    }
+
+    iterator insert(const_iterator pos, size_t n, const T &v)
+    {
+        size_t i = pos - this->ptr;
+        this->reserve(this->length + n);
+        std::copy_backward(this->ptr + i, this->ptr + this->length, this->ptr + this->length + n);
+        std::fill(this->ptr + i, this->ptr + i + n, v);
+        this->length += n;
+        return this->ptr + i;
+    }
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        size_t i = first - this->ptr;
+        size_t n = last - first;
+        std::copy(this->ptr + i + n, this->ptr + this->length, this->ptr + i);
+        this->length -= n;
+        return this->ptr + i;
+    }
+};
+
+struct LazyTerm;
+template <typename E>
+class LazyExpr;
+class BigIntView;
+
+//order of the words and of the bytes within a word for raw byte import and export
+enum class Endian
+{
+    little,
+    big,
+    native
+};
+
 class BigInt
 {
   private:
@@ -24,20 +277,96 @@ class BigInt
 
     static const size_t DIGIT_BIT = sizeof(digit_t) * CHAR_BIT;
 
+    //values up to 256 bits are stored inside the object
+    static const size_t INLINE_DIGITS = 256 / BigInt::DIGIT_BIT;
+
     static const size_t KARATSUBA_THRESHOLD = 128;
-    static std::pair<digit_t, digit_t> add(digit_t a, digit_t b, digit_t d);
-    static std::pair<digit_t, digit_t> sub(digit_t a, digit_t b, digit_t d);
+    static const size_t KARATSUBA_SQR_THRESHOLD = 128;
+#if BIGINT_DIGIT_BIT == 64
+    //the NTT splits 64 bit limbs into two words, so it takes over later
+    static const size_t TOOM3_THRESHOLD = 2048;
+    static const size_t TOOM4_THRESHOLD = 4096;
+    static const size_t NTT_THRESHOLD = 24576;
+    static const size_t TOOM3_SQR_THRESHOLD = 3072;
+    static const size_t TOOM4_SQR_THRESHOLD = 8192;
+    static const size_t NTT_SQR_THRESHOLD = 16384;
+#else
+    static const size_t TOOM3_THRESHOLD = 1024;
+    static const size_t TOOM4_THRESHOLD = 2048;
+    static const size_t NTT_THRESHOLD = 7168;
+    static const size_t TOOM3_SQR_THRESHOLD = 2048;
+    static const size_t TOOM4_SQR_THRESHOLD = 3072;
+    static const size_t NTT_SQR_THRESHOLD = 4096;
+#endif
+    static const size_t NTT_MAX_LENGTH = ((size_t)1 << 24) / (sizeof(digit_t) / sizeof(uint32_t));
+    static const size_t PARALLEL_THRESHOLD = 2048;
+    static const size_t PARALLEL_DEPTH = 2;
+    static const size_t BATCH_PARALLEL_THRESHOLD = (size_t)1 << 16;
+    static const size_t PARSE_THRESHOLD = 512;
+    static const size_t FORMAT_THRESHOLD = 64;
+    static const size_t BURNIKEL_ZIEGLER_THRESHOLD = 160;
+    static const size_t BURNIKEL_ZIEGLER_OFFSET = 80;
+    static const size_t MOD_CONTEXT_CACHE = 4;
+    static const size_t HGCD_THRESHOLD = 128;
+
+    friend class ModContext;
+    friend class BigIntView;
+    friend class MappedBigInt;
+    template <size_t Bits>
+    friend class FixedInt;
+    template <typename E>
+    friend class LazyExpr;
 
-    std::vector<digit_t> numeral;
+    SmallVector<digit_t, BigInt::INLINE_DIGITS> numeral;
     static ddigit_t cmp(const BigInt &l, const BigInt &r);
-    static BigInt complement(const BigInt &l);
+    static ddigit_t cmp(const BigInt &l, ddigit_t r);
+    static int cmpAbs(const BigInt &l, const BigInt &r);
+    static int cmpAbs(const BigInt &l, uddigit_t r);
+    template <typename Op>
+    BigInt &bitwise(const BigInt &o, Op op);
+
+    BigInt &addAbs(const BigInt &o);
+    BigInt &subAbs(const BigInt &o);
+
+    BigInt &addAbs(uddigit_t o);
+    BigInt &subAbs(uddigit_t o);
+    BigInt &mulAbs(uddigit_t o);
+    //a signed shift count ignores its sign, as a BigInt count does
+    static inline size_t shiftCount(ddigit_t o) { return o >= 0 ? (size_t)o : (size_t)0 - (size_t)o; }
+    BigInt &mulAcc(const BigInt &l, const BigInt &r, int sign);
+    BigInt &mulAcc(const BigInt &l, digit_t r, int sign);
+    static void evaluate(BigInt &r, const LazyTerm *t, size_t k);
+
+    BigInt &addAbs(const BigInt &o, size_t offset);
+    static void shiftLeft(BigInt &r, const BigInt &a, size_t bits);
+    static void shiftRight(BigInt &r, const BigInt &a, size_t bits);
+    static bool parallel(size_t n);
+    static void batch(size_t n, size_t work, const std::function<void(size_t, size_t)> &f);
+
+    static digit_t digitDiv(const BigInt &l, digit_t r, BigInt &q);
+    static digit_t digitMod(const BigInt &l, digit_t r);
+    static void div2n1n(const BigInt &l, const BigInt &r, size_t n, BigInt &q, BigInt &rem);
+    static void div3n2n(const BigInt &l, const BigInt &r, size_t n, BigInt &q, BigInt &rem);
+    static BigInt slice(const BigInt &o, size_t from, size_t to);
+
+    struct Cofactors;
+    static BigInt combine(const BigInt &p, ddigit_t x, const BigInt &q, ddigit_t y);
+    static void lehmerStep(BigInt &a, BigInt &b, Cofactors *c);
+    static void gcdReduce(BigInt &a, BigInt &b, size_t s, Cofactors *c);
+
+    static BigInt parse(const char *s, size_t length, int base);
+    static BigInt parsePow2(const char *s, size_t length, int base);
+    static BigInt parseBase(const char *s, size_t length, int base);
+    static BigInt parseDC(const char *s, size_t length, int base);
 
-    BigInt &baseMul(const BigInt &o);
-    BigInt &karatsubaMul(const BigInt &o);
+    static const BigInt &radixPower(int base, size_t i);
+    static char *formatPow2(const BigInt &o, int base, char *end);
+    static char *formatBase(const BigInt &o, int base, char *end, size_t width);
+    static char *formatDC(const BigInt &o, int base, char *end, size_t width);
 
     inline BigInt &trim()
     {
-        while (this->numeral.back() == 0)
+        while (!this->numeral.empty() && this->numeral.back() == 0)
         {
             this->numeral.pop_back();
         }
@@ -63,12 +392,60 @@ class BigInt
   public:
     BigInt();
     BigInt(ddigit_t v);
-    BigInt(std::string s);
-    BigInt(std::string s, int base);
+    BigInt(const std::string &s);
+    BigInt(const std::string &s, int base);
     BigInt(const BigInt &o);
+    BigInt(BigInt &&o) noexcept;
+    explicit BigInt(const BigIntView &v);
+
+    BigInt &operator=(const BigInt &o);
+    BigInt &operator=(BigInt &&o) noexcept;
 
     static BigInt baseMul(const BigInt &l, const BigInt &r);
-    static BigInt karatsubaMul(BigInt &l, BigInt &r);
+    static BigInt karatsubaMul(const BigInt &l, const BigInt &r);
+    static BigInt toom3Mul(const BigInt &l, const BigInt &r);
+    static BigInt toom4Mul(const BigInt &l, const BigInt &r);
+    static BigInt nttMul(const BigInt &l, const BigInt &r);
+    static BigInt mul(const BigInt &l, const BigInt &r);
+    static BigInt baseSqr(const BigInt &l);
+    static BigInt karatsubaSqr(const BigInt &l);
+    static BigInt sqr(const BigInt &l);
+
+    //Independent operations r[i] = a[i] op b[i] for i < n, such as many products of the same modest
+    //size. Each result reuses the storage of r[i], so running batches into the same results does not
+    //allocate, and basecase sized products go straight to the multiply kernels. Batches with enough
+    //work are split over the threads of setThreads.
+    static void batch_mul(const BigInt *a, const BigInt *b, BigInt *r, size_t n);
+    static void batch_add(const BigInt *a, const BigInt *b, BigInt *r, size_t n);
+    static void batch_sub(const BigInt *a, const BigInt *b, BigInt *r, size_t n);
+
+    //opt-in parallel multiplication, n threads in total including the caller, 1 by default. It may be
+    //called while other threads multiply, those calls finish on the threads that remain. Throws
+    //std::logic_error when called from inside a pool task.
+    static void setThreads(size_t n);
+    static size_t threads();
+
+    //heap storage for the digits that the calling thread allocates from now on, nullptr for operator
+    //new. Returns the previous allocator. Storage goes back to the allocator it came from, whichever
+    //thread releases it.
+    static LimbAllocator *setAllocator(LimbAllocator *a);
+
+    static void baseDiv(const BigInt &l, const BigInt &r, BigInt &q, BigInt &rem);
+    static void burnikelZieglerDiv(const BigInt &l, const BigInt &r, BigInt &q, BigInt &rem);
+    //throws std::domain_error when r is zero, as do / and %
+    static std::pair<BigInt, BigInt> divmod(const BigInt &l, const BigInt &r);
+    static std::pair<BigInt, ddigit_t> divmod(const BigInt &l, ddigit_t r);
+
+    static BigInt pow(const BigInt &l, size_t e);
+    //throws std::invalid_argument when e is negative or m is not positive
+    static BigInt powmod(const BigInt &b, const BigInt &e, const BigInt &m);
+
+    static BigInt gcd(const BigInt &l, const BigInt &r);
+    static BigInt lcm(const BigInt &l, const BigInt &r);
+    //returns gcd(l, r) and sets x and y so that l * x + r * y == gcd(l, r)
+    static BigInt gcdext(const BigInt &l, const BigInt &r, BigInt &x, BigInt &y);
+    //throws std::invalid_argument when l has no inverse modulo m or m is not positive
+    static BigInt modinv(const BigInt &l, const BigInt &m);
 
     BigInt &operator++();
     BigInt &operator--();
@@ -84,22 +461,38 @@ class BigInt
         operator--();
         return tmp;
     }
-    inline BigInt operator+()
+    inline BigInt operator+() const &
     {
         BigInt tmp(*this);
         return tmp;
     }
-    inline BigInt operator-()
+    inline BigInt operator+() &&
+    {
+        return std::move(*this);
+    }
+    inline BigInt operator-() const &
     {
         BigInt tmp(*this);
-        tmp.sign = -this->sign;
-        return tmp;
+        return -std::move(tmp);
     }
-    inline BigInt operator~()
+    inline BigInt operator-() &&
     {
-        BigInt tmp = ((*this)++);
-        tmp.sign = -tmp.sign;
-        return tmp;
+        if (this->numeral.size() != 0)
+        {
+            this->sign = -this->sign;
+        }
+        return std::move(*this);
+    }
+    inline BigInt operator~() const &
+    {
+        BigInt tmp(*this);
+        return ~std::move(tmp);
+    }
+    inline BigInt operator~() &&
+    {
+        //~x == -(x + 1)
+        ++(*this);
+        return -std::move(*this);
     }
     inline bool operator!()
     {
@@ -112,6 +505,14 @@ class BigInt
         return *this;
     }
 
+    //bits of the magnitude, 0 for zero
+    size_t bit_length() const;
+    //set bits of the magnitude
+    size_t popcount() const;
+    //bit n of the two's complement form, as seen by the bitwise operators
+    bool test_bit(size_t n) const;
+    BigInt &set_bit(size_t n, bool value = true);
+
     BigInt &operator+=(const BigInt &o);
     BigInt &operator-=(const BigInt &o);
     BigInt &operator*=(const BigInt &o);
@@ -125,31 +526,18 @@ class BigInt
     BigInt &operator>>=(const BigInt &o);
     BigInt &operator<<=(const BigInt &o);
 
-    inline BigInt &operator+=(const ddigit_t o)
-    {
-        *this += BigInt(o);
-        return *this;
-    }
-    inline BigInt &operator-=(const ddigit_t o)
-    {
-        *this -= BigInt(o);
-        return *this;
-    }
-    inline BigInt &operator*=(const ddigit_t o)
-    {
-        *this *= BigInt(o);
-        return *this;
-    }
-    inline BigInt &operator/=(const ddigit_t o)
-    {
-        *this /= BigInt(o);
-        return *this;
-    }
-    inline BigInt &operator%=(const ddigit_t o)
-    {
-        *this %= BigInt(o);
-        return *this;
-    }
+    BigInt &operator+=(const ddigit_t o);
+    BigInt &operator-=(const ddigit_t o);
+    BigInt &operator*=(const ddigit_t o);
+    BigInt &operator/=(const ddigit_t o);
+    BigInt &operator%=(const ddigit_t o);
+
+    //this += l * r and this -= l * r. Below the Toom sizes the product is accumulated straight into
+    //the digits of this, without a temporary.
+    BigInt &addmul(const BigInt &l, const BigInt &r);
+    BigInt &submul(const BigInt &l, const BigInt &r);
+    BigInt &addmul(const BigInt &l, ddigit_t r);
+    BigInt &submul(const BigInt &l, ddigit_t r);
 
     inline BigInt &operator&=(const ddigit_t o)
     {
@@ -167,24 +555,31 @@ class BigInt
         return *this;
     }
 
-    inline BigInt &operator>>=(const ddigit_t o)
+    //native bit counts, the whole result is written in one pass over the digits
+    BigInt &operator>>=(size_t o);
+    BigInt &operator<<=(size_t o);
+    template <typename T, typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value, int>::type = 0>
+    inline BigInt &operator>>=(T o)
     {
-        *this >>= BigInt(o);
-        return *this;
+        return *this >>= BigInt::shiftCount(o);
     }
-    inline BigInt &operator<<=(const ddigit_t o)
+    template <typename T, typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value, int>::type = 0>
+    inline BigInt &operator<<=(T o)
     {
-        *this <<= BigInt(o);
-        return *this;
+        return *this <<= BigInt::shiftCount(o);
     }
 
     friend inline BigInt operator+(const BigInt &l, const ddigit_t r)
     {
-        return l + BigInt(r);
+        BigInt tmp(l);
+        tmp += r;
+        return tmp;
     }
     friend inline BigInt operator+(const ddigit_t l, const BigInt &r)
     {
-        return BigInt(r) + l;
+        BigInt tmp(r);
+        tmp += l;
+        return tmp;
     }
     friend inline BigInt operator+(const BigInt &l, const BigInt &r)
     {
@@ -192,13 +587,42 @@ class BigInt
         tmp += r;
         return tmp;
     }
+    friend inline BigInt operator+(BigInt &&l, const ddigit_t r)
+    {
+        l += r;
+        return std::move(l);
+    }
+    friend inline BigInt operator+(BigInt &&l, const BigInt &r)
+    {
+        l += r;
+        return std::move(l);
+    }
+    friend inline BigInt operator+(const ddigit_t l, BigInt &&r)
+    {
+        r += l;
+        return std::move(r);
+    }
+    friend inline BigInt operator+(const BigInt &l, BigInt &&r)
+    {
+        r += l;
+        return std::move(r);
+    }
+    friend inline BigInt operator+(BigInt &&l, BigInt &&r)
+    {
+        l += r;
+        return std::move(l);
+    }
     friend inline BigInt operator-(const BigInt &l, const ddigit_t r)
     {
-        return l - BigInt(r);
+        BigInt tmp(l);
+        tmp -= r;
+        return tmp;
     }
     friend inline BigInt operator-(const ddigit_t l, const BigInt &r)
     {
-        return BigInt(l) - r;
+        BigInt tmp(r);
+        tmp -= l;
+        return -std::move(tmp);
     }
     friend inline BigInt operator-(const BigInt &l, const BigInt &r)
     {
@@ -206,23 +630,77 @@ class BigInt
         tmp -= r;
         return tmp;
     }
-    friend inline BigInt operator*(const BigInt &l, const ddigit_t r)
+    friend inline BigInt operator-(BigInt &&l, const ddigit_t r)
     {
-        return l * BigInt(r);
+        l -= r;
+        return std::move(l);
     }
-    friend inline BigInt operator*(const ddigit_t l, const BigInt &r)
+    friend inline BigInt operator-(BigInt &&l, const BigInt &r)
     {
-        return BigInt(l) * r;
+        l -= r;
+        return std::move(l);
     }
-    friend inline BigInt operator*(const BigInt &l, const BigInt &r)
+    friend inline BigInt operator-(const ddigit_t l, BigInt &&r)
+    {
+        r -= l;
+        return -std::move(r);
+    }
+    friend inline BigInt operator-(const BigInt &l, BigInt &&r)
+    {
+        r -= l;
+        return -std::move(r);
+    }
+    friend inline BigInt operator-(BigInt &&l, BigInt &&r)
+    {
+        l -= r;
+        return std::move(l);
+    }
+    friend inline BigInt operator*(const BigInt &l, const ddigit_t r)
     {
         BigInt tmp(l);
         tmp *= r;
         return tmp;
     }
+    friend inline BigInt operator*(const ddigit_t l, const BigInt &r)
+    {
+        BigInt tmp(r);
+        tmp *= l;
+        return tmp;
+    }
+    friend inline BigInt operator*(const BigInt &l, const BigInt &r)
+    {
+        return BigInt::mul(l, r);
+    }
+    friend inline BigInt operator*(BigInt &&l, const ddigit_t r)
+    {
+        l *= r;
+        return std::move(l);
+    }
+    friend inline BigInt operator*(BigInt &&l, const BigInt &r)
+    {
+        l *= r;
+        return std::move(l);
+    }
+    friend inline BigInt operator*(const ddigit_t l, BigInt &&r)
+    {
+        r *= l;
+        return std::move(r);
+    }
+    friend inline BigInt operator*(const BigInt &l, BigInt &&r)
+    {
+        r *= l;
+        return std::move(r);
+    }
+    friend inline BigInt operator*(BigInt &&l, BigInt &&r)
+    {
+        l *= r;
+        return std::move(l);
+    }
     friend inline BigInt operator/(const BigInt &l, const ddigit_t r)
     {
-        return l / BigInt(r);
+        BigInt tmp(l);
+        tmp /= r;
+        return tmp;
     }
     friend inline BigInt operator/(const ddigit_t l, const BigInt &r)
     {
@@ -234,9 +712,25 @@ class BigInt
         tmp /= r;
         return tmp;
     }
+    friend inline BigInt operator/(BigInt &&l, const ddigit_t r)
+    {
+        l /= r;
+        return std::move(l);
+    }
+    friend inline BigInt operator/(BigInt &&l, const BigInt &r)
+    {
+        l /= r;
+        return std::move(l);
+    }
+    friend inline BigInt operator/(const ddigit_t l, BigInt &&r)
+    {
+        return BigInt(l) / r;
+    }
     friend inline BigInt operator%(const BigInt &l, const ddigit_t r)
     {
-        return l % BigInt(r);
+        BigInt tmp(l);
+        tmp %= r;
+        return tmp;
     }
     friend inline BigInt operator%(const ddigit_t l, const BigInt &r)
     {
@@ -248,6 +742,20 @@ class BigInt
         tmp %= r;
         return tmp;
     }
+    friend inline BigInt operator%(BigInt &&l, const ddigit_t r)
+    {
+        l %= r;
+        return std::move(l);
+    }
+    friend inline BigInt operator%(BigInt &&l, const BigInt &r)
+    {
+        l %= r;
+        return std::move(l);
+    }
+    friend inline BigInt operator%(const ddigit_t l, BigInt &&r)
+    {
+        return BigInt(l) % r;
+    }
     friend inline BigInt operator&(const BigInt &l, const ddigit_t r)
     {
         return l & BigInt(r);
@@ -262,6 +770,31 @@ class BigInt
         tmp &= r;
         return tmp;
     }
+    friend inline BigInt operator&(BigInt &&l, const ddigit_t r)
+    {
+        l &= r;
+        return std::move(l);
+    }
+    friend inline BigInt operator&(BigInt &&l, const BigInt &r)
+    {
+        l &= r;
+        return std::move(l);
+    }
+    friend inline BigInt operator&(const ddigit_t l, BigInt &&r)
+    {
+        r &= l;
+        return std::move(r);
+    }
+    friend inline BigInt operator&(const BigInt &l, BigInt &&r)
+    {
+        r &= l;
+        return std::move(r);
+    }
+    friend inline BigInt operator&(BigInt &&l, BigInt &&r)
+    {
+        l &= r;
+        return std::move(l);
+    }
     friend inline BigInt operator|(const BigInt &l, const ddigit_t r)
     {
         return l | BigInt(r);
@@ -276,6 +809,31 @@ class BigInt
         tmp |= r;
         return tmp;
     }
+    friend inline BigInt operator|(BigInt &&l, const ddigit_t r)
+    {
+        l |= r;
+        return std::move(l);
+    }
+    friend inline BigInt operator|(BigInt &&l, const BigInt &r)
+    {
+        l |= r;
+        return std::move(l);
+    }
+    friend inline BigInt operator|(const ddigit_t l, BigInt &&r)
+    {
+        r |= l;
+        return std::move(r);
+    }
+    friend inline BigInt operator|(const BigInt &l, BigInt &&r)
+    {
+        r |= l;
+        return std::move(r);
+    }
+    friend inline BigInt operator|(BigInt &&l, BigInt &&r)
+    {
+        l |= r;
+        return std::move(l);
+    }
     friend inline BigInt operator^(const BigInt &l, const ddigit_t r)
     {
         return l ^ BigInt(r);
@@ -290,9 +848,36 @@ class BigInt
         tmp ^= r;
         return tmp;
     }
-    friend inline BigInt operator>>(const BigInt &l, const ddigit_t r)
+    friend inline BigInt operator^(BigInt &&l, const ddigit_t r)
+    {
+        l ^= r;
+        return std::move(l);
+    }
+    friend inline BigInt operator^(BigInt &&l, const BigInt &r)
     {
-        return l >> BigInt(r);
+        l ^= r;
+        return std::move(l);
+    }
+    friend inline BigInt operator^(const ddigit_t l, BigInt &&r)
+    {
+        r ^= l;
+        return std::move(r);
+    }
+    friend inline BigInt operator^(const BigInt &l, BigInt &&r)
+    {
+        r ^= l;
+        return std::move(r);
+    }
+    friend inline BigInt operator^(BigInt &&l, BigInt &&r)
+    {
+        l ^= r;
+        return std::move(l);
+    }
+    friend inline BigInt operator>>(const BigInt &l, size_t r)
+    {
+        BigInt tmp;
+        BigInt::shiftRight(tmp, l, r);
+        return tmp;
     }
     friend inline BigInt operator>>(const ddigit_t l, const BigInt &r)
     {
@@ -304,9 +889,35 @@ class BigInt
         tmp >>= r;
         return tmp;
     }
-    friend inline BigInt operator<<(const BigInt &l, const ddigit_t r)
+    friend inline BigInt operator>>(BigInt &&l, size_t r)
+    {
+        l >>= r;
+        return std::move(l);
+    }
+    template <typename T, typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value, int>::type = 0>
+    friend inline BigInt operator>>(const BigInt &l, T r)
     {
-        return l << BigInt(r);
+        return l >> BigInt::shiftCount(r);
+    }
+    template <typename T, typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value, int>::type = 0>
+    friend inline BigInt operator>>(BigInt &&l, T r)
+    {
+        return std::move(l) >> BigInt::shiftCount(r);
+    }
+    friend inline BigInt operator>>(BigInt &&l, const BigInt &r)
+    {
+        l >>= r;
+        return std::move(l);
+    }
+    friend inline BigInt operator>>(const ddigit_t l, BigInt &&r)
+    {
+        return BigInt(l) >> r;
+    }
+    friend inline BigInt operator<<(const BigInt &l, size_t r)
+    {
+        BigInt tmp;
+        BigInt::shiftLeft(tmp, l, r);
+        return tmp;
     }
     friend inline BigInt operator<<(const ddigit_t l, const BigInt &r)
     {
@@ -318,35 +929,696 @@ class BigInt
         tmp <<= r;
         return tmp;
     }
+    friend inline BigInt operator<<(BigInt &&l, size_t r)
+    {
+        l <<= r;
+        return std::move(l);
+    }
+    template <typename T, typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value, int>::type = 0>
+    friend inline BigInt operator<<(const BigInt &l, T r)
+    {
+        return l << BigInt::shiftCount(r);
+    }
+    template <typename T, typename std::enable_if<std::is_integral<T>::value && std::is_signed<T>::value, int>::type = 0>
+    friend inline BigInt operator<<(BigInt &&l, T r)
+    {
+        return std::move(l) << BigInt::shiftCount(r);
+    }
+    friend inline BigInt operator<<(BigInt &&l, const BigInt &r)
+    {
+        l <<= r;
+        return std::move(l);
+    }
+    friend inline BigInt operator<<(const ddigit_t l, BigInt &&r)
+    {
+        return BigInt(l) << r;
+    }
 
-    friend inline bool operator==(const BigInt &l, const ddigit_t r) { return BigInt::cmp(l, BigInt(r)) == 0; }
-    friend inline bool operator==(const ddigit_t l, const BigInt &r) { return BigInt::cmp(BigInt(l), r) == 0; }
+    friend inline bool operator==(const BigInt &l, const ddigit_t r) { return BigInt::cmp(l, r) == 0; }
+    friend inline bool operator==(const ddigit_t l, const BigInt &r) { return -BigInt::cmp(r, l) == 0; }
     friend inline bool operator==(const BigInt &l, const BigInt &r) { return BigInt::cmp(l, r) == 0; }
 
-    friend inline bool operator!=(const BigInt &l, const ddigit_t r) { return BigInt::cmp(l, BigInt(r)) != 0; }
-    friend inline bool operator!=(const ddigit_t l, const BigInt &r) { return BigInt::cmp(BigInt(l), r) != 0; }
+    friend inline bool operator!=(const BigInt &l, const ddigit_t r) { return BigInt::cmp(l, r) != 0; }
+    friend inline bool operator!=(const ddigit_t l, const BigInt &r) { return -BigInt::cmp(r, l) != 0; }
     friend inline bool operator!=(const BigInt &l, const BigInt &r) { return BigInt::cmp(l, r) != 0; }
 
-    friend inline bool operator<(const BigInt &l, const ddigit_t r) { return BigInt::cmp(l, BigInt(r)) < 0; }
-    friend inline bool operator<(const ddigit_t l, const BigInt &r) { return BigInt::cmp(BigInt(l), r) < 0; }
+    friend inline bool operator<(const BigInt &l, const ddigit_t r) { return BigInt::cmp(l, r) < 0; }
+    friend inline bool operator<(const ddigit_t l, const BigInt &r) { return -BigInt::cmp(r, l) < 0; }
     friend inline bool operator<(const BigInt &l, const BigInt &r) { return BigInt::cmp(l, r) < 0; }
 
-    friend inline bool operator>(const BigInt &l, const ddigit_t r) { return BigInt::cmp(l, BigInt(r)) > 0; }
-    friend inline bool operator>(const ddigit_t l, const BigInt &r) { return BigInt::cmp(BigInt(l), r) > 0; }
+    friend inline bool operator>(const BigInt &l, const ddigit_t r) { return BigInt::cmp(l, r) > 0; }
+    friend inline bool operator>(const ddigit_t l, const BigInt &r) { return -BigInt::cmp(r, l) > 0; }
     friend inline bool operator>(const BigInt &l, const BigInt &r) { return BigInt::cmp(l, r) > 0; }
 
-    friend inline bool operator<=(const BigInt &l, const ddigit_t r) { return BigInt::cmp(l, BigInt(r)) <= 0; }
-    friend inline bool operator<=(const ddigit_t l, const BigInt &r) { return BigInt::cmp(BigInt(l), r) <= 0; }
+    friend inline bool operator<=(const BigInt &l, const ddigit_t r) { return BigInt::cmp(l, r) <= 0; }
+    friend inline bool operator<=(const ddigit_t l, const BigInt &r) { return -BigInt::cmp(r, l) <= 0; }
     friend inline bool operator<=(const BigInt &l, const BigInt &r) { return BigInt::cmp(l, r) <= 0; }
 
-    friend inline bool operator>=(const BigInt &l, const ddigit_t r) { return BigInt::cmp(l, BigInt(r)) >= 0; }
-    friend inline bool operator>=(const ddigit_t l, const BigInt &r) { return BigInt::cmp(BigInt(l), r) >= 0; }
+    friend inline bool operator>=(const BigInt &l, const ddigit_t r) { return BigInt::cmp(l, r) >= 0; }
+    friend inline bool operator>=(const ddigit_t l, const BigInt &r) { return -BigInt::cmp(r, l) >= 0; }
     friend inline bool operator>=(const BigInt &l, const BigInt &r) { return BigInt::cmp(l, r) >= 0; }
 
+    std::string to_string(int base = 10) const;
+
+    //The magnitude as count words of word bytes, as mpz_import and mpz_export in GMP do. order is the
+    //order of the words, endian the order of the bytes within each word.
+    static BigInt import_bytes(const void *data, size_t count, size_t word, Endian order, Endian endian);
+    //words needed by export_bytes, 0 for zero
+    size_t export_size(size_t word) const;
+    //fills all count words, zero padded at the top, and returns the number of significant ones. Throws
+    //std::invalid_argument when the magnitude does not fit.
+    size_t export_bytes(void *data, size_t count, size_t word, Endian order, Endian endian) const;
+
+    //Binary format: a little endian 64 bit header holding the number of magnitude words shifted left
+    //by one and the sign in bit 0, then the magnitude in little endian 64 bit words, least significant
+    //first. It is the same for either limb width and any host.
+    size_t serialized_size() const;
+    //returns the number of bytes written, throws std::invalid_argument when size is too small
+    size_t serialize(void *out, size_t size) const;
+    //reads one value from the front of in and sets used to its size in bytes. Throws
+    //std::invalid_argument when in is shorter than the value.
+    static BigInt deserialize(const void *in, size_t size, size_t *used = nullptr);
+
     friend inline BigInt abs(const BigInt &o) { return (BigInt(o)).abs(); }
+    friend inline BigInt fma(const BigInt &a, const BigInt &b, const BigInt &c) { return BigInt(c).addmul(a, b); }
+    friend inline std::pair<BigInt, BigInt> divmod(const BigInt &l, const BigInt &r) { return BigInt::divmod(l, r); }
+    friend inline std::pair<BigInt, ddigit_t> divmod(const BigInt &l, const ddigit_t r) { return BigInt::divmod(l, r); }
+    friend inline BigInt pow(const BigInt &l, size_t e) { return BigInt::pow(l, e); }
+    friend inline BigInt powmod(const BigInt &b, const BigInt &e, const BigInt &m) { return BigInt::powmod(b, e, m); }
+    friend inline BigInt gcd(const BigInt &l, const BigInt &r) { return BigInt::gcd(l, r); }
+    friend inline BigInt lcm(const BigInt &l, const BigInt &r) { return BigInt::lcm(l, r); }
+    friend inline BigInt gcdext(const BigInt &l, const BigInt &r, BigInt &x, BigInt &y) { return BigInt::gcdext(l, r, x, y); }
+    friend inline BigInt modinv(const BigInt &l, const BigInt &m) { return BigInt::modinv(l, m); }
 
     ~BigInt();
     friend std::ostream &operator<<(std::ostream &os, const BigInt &dt);
 };
 
+//Bump allocator for the many short lived values of a unit of work, such as a request. Nothing is
+//reclaimed until reset(), which makes the storage of every value still using it invalid. Not thread
+//safe, install one per thread.
+class Arena : public LimbAllocator
+{
+  private:
+    struct Chunk
+    {
+        Chunk *next;
+        size_t size;
+    };
+    Chunk *first;
+    Chunk *current;
+    unsigned char *top;
+    unsigned char *limit;
+    size_t chunkSize;
+    size_t bytes;
+
+  public:
+    explicit Arena(size_t chunkSize = (size_t)1 << 16);
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+    ~Arena();
+
+    void *allocate(size_t bytes) override;
+    void deallocate(void *p, size_t bytes) override;
+
+    //starts over at the first chunk, the chunks are kept for reuse
+    void reset();
+    //bytes handed out since the last reset
+    inline size_t used() const { return this->bytes; }
+};
+
+//Read only value over limbs that live elsewhere, such as a mapped file or a network buffer, least
+//significant first. Nothing is copied, the limbs must outlive the view. Arithmetic goes through
+//BigInt(view), which copies.
+class BigIntView
+{
+  private:
+    const digit_t *d;
+    size_t n;
+    bool neg;
+
+  public:
+    BigIntView() : d(nullptr), n(0), neg(false) {}
+    //leading zero limbs are left out of the view
+    BigIntView(const digit_t *d, size_t n, bool negative = false);
+    BigIntView(const BigInt &o) : d(o.numeral.data()), n(o.numeral.size()), neg(o.sign < 0) {}
+
+    //a value in the format of BigInt::serialize read in place, which takes a little endian host and
+    //the magnitude aligned for digit_t. Throws std::invalid_argument otherwise, or when in is shorter
+    //than the value.
+    static BigIntView deserialize(const void *in, size_t size, size_t *used = nullptr);
+
+    inline const digit_t *data() const { return this->d; }
+    inline size_t size() const { return this->n; }
+    inline bool negative() const { return this->neg; }
+
+    size_t bit_length() const;
+    size_t export_size(size_t word) const;
+    size_t export_bytes(void *data, size_t count, size_t word, Endian order, Endian endian) const;
+    size_t serialized_size() const;
+    size_t serialize(void *out, size_t size) const;
+
+    inline std::string to_string(int base = 10) const { return BigInt(*this).to_string(base); }
+
+    static int cmp(const BigIntView &l, const BigIntView &r);
+
+    friend inline bool operator==(const BigIntView &l, const BigIntView &r) { return BigIntView::cmp(l, r) == 0; }
+    friend inline bool operator!=(const BigIntView &l, const BigIntView &r) { return BigIntView::cmp(l, r) != 0; }
+    friend inline bool operator<(const BigIntView &l, const BigIntView &r) { return BigIntView::cmp(l, r) < 0; }
+    friend inline bool operator>(const BigIntView &l, const BigIntView &r) { return BigIntView::cmp(l, r) > 0; }
+    friend inline bool operator<=(const BigIntView &l, const BigIntView &r) { return BigIntView::cmp(l, r) <= 0; }
+    friend inline bool operator>=(const BigIntView &l, const BigIntView &r) { return BigIntView::cmp(l, r) >= 0; }
+};
+
+//Unsigned integer of a fixed number of bits, a multiple of the limb width, with wrap-around arithmetic
+//modulo 2^Bits like the built-in unsigned types. The limbs live inside the object and every loop runs
+//a compile-time number of times, so there is no heap traffic, no trimming and no size dispatch.
+//Construction, limb access and comparisons are constexpr. Conversion from a BigInt keeps its low Bits
+//bits in two's complement.
+template <size_t Bits>
+class FixedInt
+{
+  private:
+    static const size_t DIGIT_BIT = sizeof(digit_t) * CHAR_BIT;
+    static_assert(Bits % (sizeof(digit_t) * CHAR_BIT) == 0 && Bits >= 64, "FixedInt: Bits must be a multiple of the limb width and at least 64");
+
+  public:
+    static const size_t N = Bits / (sizeof(digit_t) * CHAR_BIT);
+
+  private:
+    template <size_t>
+    friend class FixedInt;
+
+    digit_t d[N];
+
+    constexpr bool equal(const FixedInt &o, size_t i) const
+    {
+        return i == N || (this->d[i] == o.d[i] && this->equal(o, i + 1));
+    }
+    //compares the limbs below i, most significant first
+    constexpr int compare(const FixedInt &o, size_t i) const
+    {
+        return i == 0 ? 0 : this->d[i - 1] != o.d[i - 1] ? (this->d[i - 1] < o.d[i - 1] ? -1 : 1) : this->compare(o, i - 1);
+    }
+
+  public:
+    constexpr FixedInt() : d{} {}
+#if BIGINT_DIGIT_BIT == 64
+    constexpr FixedInt(uint64_t v) : d{(digit_t)v} {}
+#else
+    constexpr FixedInt(uint64_t v) : d{(digit_t)v, (digit_t)(v >> 32)} {}
+#endif
+    explicit FixedInt(const BigInt &o) : d{}
+    {
+        size_t n = std::min(o.numeral.size(), N);
+        std::copy(o.numeral.begin(), o.numeral.begin() + n, this->d);
+        if (o.sign < 0)
+        {
+            *this = -*this;
+        }
+    }
+    explicit operator BigInt() const
+    {
+        BigInt r;
+        r.numeral.assign(this->d, this->d + N);
+        return r.trim();
+    }
+
+    constexpr digit_t limb(size_t i) const { return this->d[i]; }
+    inline digit_t *data() { return this->d; }
+    inline const digit_t *data() const { return this->d; }
+
+    inline std::string to_string(int base = 10) const { return BigInt(*this).to_string(base); }
+
+    FixedInt &operator+=(const FixedInt &o)
+    {
+        digit_t c = 0;
+        for (size_t i = 0; i < N; i++)
+        {
+            uddigit_t t = (uddigit_t)this->d[i] + o.d[i] + c;
+            this->d[i] = (digit_t)t;
+            c = (digit_t)(t >> DIGIT_BIT);
+        }
+        return *this;
+    }
+    FixedInt &operator-=(const FixedInt &o)
+    {
+        digit_t b = 0;
+        for (size_t i = 0; i < N; i++)
+        {
+            uddigit_t t = (uddigit_t)this->d[i] - o.d[i] - b;
+            this->d[i] = (digit_t)t;
+            b = (digit_t)(t >> DIGIT_BIT) & 1;
+        }
+        return *this;
+    }
+    //schoolbook on the limbs below 2^Bits only
+    FixedInt &operator*=(const FixedInt &o)
+    {
+        digit_t r[N] = {};
+        for (size_t i = 0; i < N; i++)
+        {
+            digit_t c = 0;
+            for (size_t j = 0; i + j < N; j++)
+            {
+                uddigit_t t = (uddigit_t)this->d[i] * o.d[j] + r[i + j] + c;
+                r[i + j] = (digit_t)t;
+                c = (digit_t)(t >> DIGIT_BIT);
+            }
+        }
+        std::copy(r, r + N, this->d);
+        return *this;
+    }
+    //the full product of 2 * Bits bits
+    static FixedInt<2 * Bits> mul_wide(const FixedInt &a, const FixedInt &b)
+    {
+        FixedInt<2 * Bits> r;
+        for (size_t i = 0; i < N; i++)
+        {
+            digit_t c = 0;
+            for (size_t j = 0; j < N; j++)
+            {
+                uddigit_t t = (uddigit_t)a.d[i] * b.d[j] + r.d[i + j] + c;
+                r.d[i + j] = (digit_t)t;
+                c = (digit_t)(t >> DIGIT_BIT);
+            }
+            r.d[i + N] = c;
+        }
+        return r;
+    }
+
+    FixedInt &operator<<=(size_t s)
+    {
+        size_t q = std::min(s / DIGIT_BIT, N);
+        unsigned b = s % DIGIT_BIT;
+        for (size_t i = N; i-- > q;)
+        {
+            digit_t lo = i > q ? this->d[i - q - 1] : 0;
+            this->d[i] = b != 0 ? (this->d[i - q] << b) | (lo >> (DIGIT_BIT - b)) : this->d[i - q];
+        }
+        std::fill(this->d, this->d + q, 0);
+        return *this;
+    }
+    FixedInt &operator>>=(size_t s)
+    {
+        size_t q = std::min(s / DIGIT_BIT, N);
+        unsigned b = s % DIGIT_BIT;
+        for (size_t i = 0; i + q < N; i++)
+        {
+            digit_t hi = i + q + 1 < N ? this->d[i + q + 1] : 0;
+            this->d[i] = b != 0 ? (this->d[i + q] >> b) | (hi << (DIGIT_BIT - b)) : this->d[i + q];
+        }
+        std::fill(this->d + N - q, this->d + N, 0);
+        return *this;
+    }
+
+    FixedInt &operator&=(const FixedInt &o)
+    {
+        for (size_t i = 0; i < N; i++)
+        {
+            this->d[i] &= o.d[i];
+        }
+        return *this;
+    }
+    FixedInt &operator|=(const FixedInt &o)
+    {
+        for (size_t i = 0; i < N; i++)
+        {
+            this->d[i] |= o.d[i];
+        }
+        return *this;
+    }
+    FixedInt &operator^=(const FixedInt &o)
+    {
+        for (size_t i = 0; i < N; i++)
+        {
+            this->d[i] ^= o.d[i];
+        }
+        return *this;
+    }
+    FixedInt operator~() const
+    {
+        FixedInt r;
+        for (size_t i = 0; i < N; i++)
+        {
+            r.d[i] = ~this->d[i];
+        }
+        return r;
+    }
+    FixedInt operator-() const
+    {
+        return FixedInt() - *this;
+    }
+
+    friend inline FixedInt operator+(FixedInt l, const FixedInt &r) { return l += r; }
+    friend inline FixedInt operator-(FixedInt l, const FixedInt &r) { return l -= r; }
+    friend inline FixedInt operator*(FixedInt l, const FixedInt &r) { return l *= r; }
+    friend inline FixedInt operator&(FixedInt l, const FixedInt &r) { return l &= r; }
+    friend inline FixedInt operator|(FixedInt l, const FixedInt &r) { return l |= r; }
+    friend inline FixedInt operator^(FixedInt l, const FixedInt &r) { return l ^= r; }
+    friend inline FixedInt operator<<(FixedInt l, size_t r) { return l <<= r; }
+    friend inline FixedInt operator>>(FixedInt l, size_t r) { return l >>= r; }
+
+    friend constexpr bool operator==(const FixedInt &l, const FixedInt &r) { return l.equal(r, 0); }
+    friend constexpr bool operator!=(const FixedInt &l, const FixedInt &r) { return !l.equal(r, 0); }
+    friend constexpr bool operator<(const FixedInt &l, const FixedInt &r) { return l.compare(r, N) < 0; }
+    friend constexpr bool operator>(const FixedInt &l, const FixedInt &r) { return l.compare(r, N) > 0; }
+    friend constexpr bool operator<=(const FixedInt &l, const FixedInt &r) { return l.compare(r, N) <= 0; }
+    friend constexpr bool operator>=(const FixedInt &l, const FixedInt &r) { return l.compare(r, N) >= 0; }
+
+    friend inline std::ostream &operator<<(std::ostream &os, const FixedInt &v) { return os << BigInt(v); }
+};
+
+template <size_t Bits>
+const size_t FixedInt<Bits>::DIGIT_BIT;
+template <size_t Bits>
+const size_t FixedInt<Bits>::N;
+
+//Value in a file in the format of BigInt::serialize, mapped into memory so that it can be larger than
+//physical memory: the kernel pages the limbs in and out as they are used. The operations stream
+//through their operands in tiles and write the result to a new file, the operands can be any views,
+//mapped or not. POSIX and little endian hosts only, failures to create, open or map a file throw
+//std::runtime_error.
+class MappedBigInt
+{
+  private:
+    int fd;
+    unsigned char *base;
+    size_t length;
+
+    //digits per tile of add and sub, and the default for mul, which keeps three tiles and a product
+    //of two in memory
+    static const size_t ADD_TILE = (size_t)1 << 16;
+    static const size_t MUL_TILE = (size_t)1 << 20;
+
+    MappedBigInt(const std::string &path, size_t digits);
+    inline digit_t *digits() { return reinterpret_cast<digit_t *>(this->base + 8); }
+    void finish(bool negative);
+
+  public:
+    //maps an existing file read only
+    explicit MappedBigInt(const std::string &path);
+    MappedBigInt(MappedBigInt &&o) noexcept;
+    MappedBigInt &operator=(MappedBigInt &&o) noexcept;
+    MappedBigInt(const MappedBigInt &) = delete;
+    MappedBigInt &operator=(const MappedBigInt &) = delete;
+    ~MappedBigInt();
+
+    BigIntView view() const;
+
+    static MappedBigInt store(const std::string &path, const BigIntView &v);
+    static MappedBigInt add(const std::string &path, const BigIntView &a, const BigIntView &b);
+    static MappedBigInt sub(const std::string &path, const BigIntView &a, const BigIntView &b);
+    //each output tile of tile digits is the sum of the in memory products of the input tiles under it,
+    //so the result is written once, in order
+    static MappedBigInt mul(const std::string &path, const BigIntView &a, const BigIntView &b, size_t tile = MUL_TILE);
+};
+
+//Precomputed state for arithmetic modulo a fixed positive m of n digits. Odd moduli multiply in
+//Montgomery form with R = B^n, even ones fall back to Barrett reduction. Build one per modulus and
+//reuse it, so that repeated operations skip the setup and share a per thread workspace.
+class ModContext
+{
+  private:
+    BigInt m;
+    size_t n;
+    digit_t ninv; //-m^-1 mod B, odd moduli only
+    BigInt one;   //R mod m
+    BigInt r2;    //R^2 mod m
+    BigInt mu;    //floor(B^2n / m)
+
+    BigInt residue(const BigInt &x) const;
+    BigInt reduce(const BigInt &x) const;
+    BigInt montMul(const BigInt &a, const BigInt &b) const;
+
+  public:
+    //throws std::invalid_argument when m is not positive
+    explicit ModContext(const BigInt &m);
+
+    inline const BigInt &modulus() const { return this->m; }
+    inline bool odd() const { return (this->m.numeral[0] & 1) != 0; }
+
+    //The operations below take and return residues in [0, m) in the form of the context: Montgomery
+    //form x * R mod m for odd moduli, plain residues for even ones. Sums and differences are the same
+    //in either form.
+    BigInt toMontgomery(const BigInt &x) const;
+    BigInt fromMontgomery(const BigInt &a) const;
+    BigInt mulmod(const BigInt &a, const BigInt &b) const;
+    BigInt sqrmod(const BigInt &a) const;
+    BigInt addmod(const BigInt &a, const BigInt &b) const;
+    BigInt submod(const BigInt &a, const BigInt &b) const;
+    //throws std::invalid_argument when a has no inverse modulo m
+    BigInt inv(const BigInt &a) const;
+
+    //sliding window exponentiation, b may be negative or larger than m. Throws std::invalid_argument
+    //when e is negative.
+    BigInt powmod(const BigInt &b, const BigInt &e) const;
+    //fixed window over every bit of e with a full table scan per window, for odd moduli only. For
+    //0 <= b < B^n neither the operations performed nor the memory accessed depend on the values of b
+    //and e, only on the number of digits of b, e and m. A negative or longer b is first reduced mod m
+    //in variable time. Throws std::invalid_argument when e is negative or m is even.
+    BigInt powmodSec(const BigInt &b, const BigInt &e) const;
+};
+
+//Opt-in lazy arithmetic. lazy(x) wraps a value so that + - * << >> on it build an expression tree
+//instead of BigInt temporaries. The tree is evaluated when it converts to a BigInt, or into an
+//existing value with into(r). Sums and differences of any number of terms, shifted ones included, are
+//added block by block into a result sized once, and products in a sum are accumulated into it with
+//addmul. A tree refers to its operands, evaluate it within the full expression that built it.
+
+//sign * v * w, or sign * v shifted left by shift bits (right when negative) without a second factor
+struct LazyTerm
+{
+    const BigInt *v;
+    const BigInt *w;
+    ptrdiff_t shift;
+    int sign;
+};
+
+template <typename E>
+class LazyExpr
+{
+  public:
+    inline const E &self() const { return static_cast<const E &>(*this); }
+
+    BigInt &into(BigInt &r) const
+    {
+        LazyTerm terms[E::TERMS];
+        BigInt tmp[E::TEMPS != 0 ? E::TEMPS : 1];
+        LazyTerm *t = terms;
+        BigInt *s = tmp;
+        this->self().collect(t, 1, s);
+        BigInt::evaluate(r, terms, t - terms);
+        return r;
+    }
+
+    operator BigInt() const
+    {
+        BigInt r;
+        this->into(r);
+        return r;
+    }
+};
+
+class LazyValue : public LazyExpr<LazyValue>
+{
+  private:
+    const BigInt *v;
+
+  public:
+    static const size_t TERMS = 1;
+    static const size_t TEMPS = 0;
+
+    explicit LazyValue(const BigInt &v) : v(&v) {}
+    inline const BigInt *value() const { return this->v; }
+
+    inline void collect(LazyTerm *&t, int sign, BigInt *&) const
+    {
+        *t++ = LazyTerm{this->v, nullptr, 0, sign};
+    }
+};
+
+//operand of a product or a shift, values are used in place and anything else is evaluated first
+template <typename E>
+inline const BigInt *lazyOperand(const LazyExpr<E> &e, BigInt *&s)
+{
+    e.into(*s);
+    return s++;
+}
+
+inline const BigInt *lazyOperand(const LazyExpr<LazyValue> &e, BigInt *&)
+{
+    return e.self().value();
+}
+
+//number of operands that lazyOperand evaluates into a temporary
+template <typename E>
+struct LazyTemps
+{
+    static const size_t value = 1;
+};
+
+template <>
+struct LazyTemps<LazyValue>
+{
+    static const size_t value = 0;
+};
+
+//l + S * r, with S either 1 or -1
+template <typename L, typename R, int S>
+class LazySum : public LazyExpr<LazySum<L, R, S>>
+{
+  private:
+    L l;
+    R r;
+
+  public:
+    static const size_t TERMS = L::TERMS + R::TERMS;
+    static const size_t TEMPS = L::TEMPS + R::TEMPS;
+
+    LazySum(const L &l, const R &r) : l(l), r(r) {}
+
+    inline void collect(LazyTerm *&t, int sign, BigInt *&s) const
+    {
+        this->l.collect(t, sign, s);
+        this->r.collect(t, sign * S, s);
+    }
+};
+
+template <typename L, typename R>
+class LazyProduct : public LazyExpr<LazyProduct<L, R>>
+{
+  private:
+    L l;
+    R r;
+
+  public:
+    static const size_t TERMS = 1;
+    static const size_t TEMPS = LazyTemps<L>::value + LazyTemps<R>::value;
+
+    LazyProduct(const L &l, const R &r) : l(l), r(r) {}
+
+    inline void collect(LazyTerm *&t, int sign, BigInt *&s) const
+    {
+        const BigInt *a = lazyOperand(this->l, s);
+        const BigInt *b = lazyOperand(this->r, s);
+        *t++ = LazyTerm{a, b, 0, sign};
+    }
+};
+
+template <typename E>
+class LazyShift : public LazyExpr<LazyShift<E>>
+{
+  private:
+    E e;
+    ptrdiff_t shift;
+
+  public:
+    static const size_t TERMS = 1;
+    static const size_t TEMPS = LazyTemps<E>::value;
+
+    LazyShift(const E &e, ptrdiff_t shift) : e(e), shift(shift) {}
+
+    inline void collect(LazyTerm *&t, int sign, BigInt *&s) const
+    {
+        *t++ = LazyTerm{lazyOperand(this->e, s), nullptr, this->shift, sign};
+    }
+};
+
+inline LazyValue lazy(const BigInt &v)
+{
+    return LazyValue(v);
+}
+
+//the BigInt && overloads keep a temporary operand lazy instead of converting the expression for
+//the eager operators, the temporary lives until the end of the full expression
+template <typename L, typename R>
+inline LazySum<L, R, 1> operator+(const LazyExpr<L> &l, const LazyExpr<R> &r)
+{
+    return LazySum<L, R, 1>(l.self(), r.self());
+}
+template <typename L>
+inline LazySum<L, LazyValue, 1> operator+(const LazyExpr<L> &l, const BigInt &r)
+{
+    return LazySum<L, LazyValue, 1>(l.self(), LazyValue(r));
+}
+template <typename R>
+inline LazySum<LazyValue, R, 1> operator+(const BigInt &l, const LazyExpr<R> &r)
+{
+    return LazySum<LazyValue, R, 1>(LazyValue(l), r.self());
+}
+template <typename L>
+inline LazySum<L, LazyValue, 1> operator+(const LazyExpr<L> &l, BigInt &&r)
+{
+    return LazySum<L, LazyValue, 1>(l.self(), LazyValue(r));
+}
+template <typename R>
+inline LazySum<LazyValue, R, 1> operator+(BigInt &&l, const LazyExpr<R> &r)
+{
+    return LazySum<LazyValue, R, 1>(LazyValue(l), r.self());
+}
+
+template <typename L, typename R>
+inline LazySum<L, R, -1> operator-(const LazyExpr<L> &l, const LazyExpr<R> &r)
+{
+    return LazySum<L, R, -1>(l.self(), r.self());
+}
+template <typename L>
+inline LazySum<L, LazyValue, -1> operator-(const LazyExpr<L> &l, const BigInt &r)
+{
+    return LazySum<L, LazyValue, -1>(l.self(), LazyValue(r));
+}
+template <typename R>
+inline LazySum<LazyValue, R, -1> operator-(const BigInt &l, const LazyExpr<R> &r)
+{
+    return LazySum<LazyValue, R, -1>(LazyValue(l), r.self());
+}
+template <typename L>
+inline LazySum<L, LazyValue, -1> operator-(const LazyExpr<L> &l, BigInt &&r)
+{
+    return LazySum<L, LazyValue, -1>(l.self(), LazyValue(r));
+}
+template <typename R>
+inline LazySum<LazyValue, R, -1> operator-(BigInt &&l, const LazyExpr<R> &r)
+{
+    return LazySum<LazyValue, R, -1>(LazyValue(l), r.self());
+}
+
+template <typename L, typename R>
+inline LazyProduct<L, R> operator*(const LazyExpr<L> &l, const LazyExpr<R> &r)
+{
+    return LazyProduct<L, R>(l.self(), r.self());
+}
+template <typename L>
+inline LazyProduct<L, LazyValue> operator*(const LazyExpr<L> &l, const BigInt &r)
+{
+    return LazyProduct<L, LazyValue>(l.self(), LazyValue(r));
+}
+template <typename R>
+inline LazyProduct<LazyValue, R> operator*(const BigInt &l, const LazyExpr<R> &r)
+{
+    return LazyProduct<LazyValue, R>(LazyValue(l), r.self());
+}
+template <typename L>
+inline LazyProduct<L, LazyValue> operator*(const LazyExpr<L> &l, BigInt &&r)
+{
+    return LazyProduct<L, LazyValue>(l.self(), LazyValue(r));
+}
+template <typename R>
+inline LazyProduct<LazyValue, R> operator*(BigInt &&l, const LazyExpr<R> &r)
+{
+    return LazyProduct<LazyValue, R>(LazyValue(l), r.self());
+}
+
+template <typename E>
+inline LazyShift<E> operator<<(const LazyExpr<E> &e, size_t n)
+{
+    return LazyShift<E>(e.self(), (ptrdiff_t)n);
+}
+template <typename E>
+inline LazyShift<E> operator>>(const LazyExpr<E> &e, size_t n)
+{
+    return LazyShift<E>(e.self(), -(ptrdiff_t)n);
+}
+
 } // namespace bigint